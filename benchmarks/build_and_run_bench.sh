@@ -6,6 +6,12 @@ set -o errexit -o nounset  # fail on error or on unset variables
 : "${CXX_COMPILER:=g++}"
 : "${CXX_FLAGS:=-std=c++11}"
 
-"$CXX_COMPILER" ${CXX_FLAGS} -O2 -Wall -pedantic -I.. enaml_like_benchmark.cpp -o run_bench
+"$CXX_COMPILER" ${CXX_FLAGS} -O2 -Wall -pedantic -pthread -I.. enaml_like_benchmark.cpp -o run_bench
+"$CXX_COMPILER" ${CXX_FLAGS} -O2 -Wall -pedantic -I.. rowmap_benchmark.cpp -o run_rowmap_bench
+"$CXX_COMPILER" ${CXX_FLAGS} -O2 -Wall -pedantic -I.. mappolicy_benchmark.cpp -o run_mappolicy_bench
+"$CXX_COMPILER" ${CXX_FLAGS} -O2 -Wall -pedantic -I.. scalar_benchmark.cpp -o run_scalar_bench
 
 ./run_bench
+./run_rowmap_bench
+./run_mappolicy_bench
+./run_scalar_bench
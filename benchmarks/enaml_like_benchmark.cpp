@@ -11,174 +11,32 @@
 #include <kiwi/kiwi.h>
 #define ANKERL_NANOBENCH_IMPLEMENT
 #include "nanobench.h"
+#include "enaml_like.h"
 
 using namespace kiwi;
 
-void build_solver(Solver& solver, Variable& width, Variable& height)
+// Collect the constraints of forms, to add them to a solver in one batch.
+struct Dashboard
 {
-    // Create custom strength
-    double mmedium = strength::create(0.0, 1.0, 0.0, 1.25);
-    double smedium = strength::create(0.0, 100, 0.0);
-
-    // Create the variable
-    Variable left("left");
-    Variable top("top");
-    Variable contents_top("contents_top");
-    Variable contents_bottom("contents_bottom");
-    Variable contents_left("contents_left");
-    Variable contents_right("contents_right");
-    Variable midline("midline");
-    Variable ctleft("ctleft");
-    Variable ctheight("ctheight");
-    Variable cttop("cttop");
-    Variable ctwidth("ctwidth");
-    Variable lb1left("lb1left");
-    Variable lb1height("lb1height");
-    Variable lb1top("lb1top");
-    Variable lb1width("lb1width");
-    Variable lb2left("lb2left");
-    Variable lb2height("lb2height");
-    Variable lb2top("lb2top");
-    Variable lb2width("lb2width");
-    Variable lb3left("lb3left");
-    Variable lb3height("lb3height");
-    Variable lb3top("lb3top");
-    Variable lb3width("lb3width");
-    Variable fl1left("fl1left");
-    Variable fl1height("fl1height");
-    Variable fl1top("fl1top");
-    Variable fl1width("fl1width");
-    Variable fl2left("fl2left");
-    Variable fl2height("fl2height");
-    Variable fl2top("fl2top");
-    Variable fl2width("fl2width");
-    Variable fl3left("fl3left");
-    Variable fl3height("fl3height");
-    Variable fl3top("fl3top");
-    Variable fl3width("fl3width");
-
-    // Add the edit variables
-    solver.addEditVariable(width, strength::strong);
-    solver.addEditVariable(height, strength::strong);
-
-    // Add the constraints
-    Constraint constraints[] = {
-        (left + -0 >= 0) | strength::required,
-        (height + 0 == 0) | strength::medium,
-        (top + -0 >= 0) | strength::required,
-        (width + -0 >= 0) | strength::required,
-        (height + -0 >= 0) | strength::required,
-        (-top + contents_top + -10 == 0) | strength::required,
-        (lb3height + -16 == 0) | strength::strong,
-        (lb3height + -16 >= 0) | strength::strong,
-        (ctleft + -0 >= 0) | strength::required,
-        (cttop + -0 >= 0) | strength::required,
-        (ctwidth + -0 >= 0) | strength::required,
-        (ctheight + -0 >= 0) | strength::required,
-        (fl3left + -0 >= 0) | strength::required,
-        (ctheight + -24 >= 0) | smedium,
-        (ctwidth + -1.67772e+07 <= 0) | smedium,
-        (ctheight + -24 <= 0) | smedium,
-        (fl3top + -0 >= 0) | strength::required,
-        (fl3width + -0 >= 0) | strength::required,
-        (fl3height + -0 >= 0) | strength::required,
-        (lb1width + -67 == 0) | strength::weak,
-        (lb2width + -0 >= 0) | strength::required,
-        (lb2height + -0 >= 0) | strength::required,
-        (fl2height + -0 >= 0) | strength::required,
-        (lb3left + -0 >= 0) | strength::required,
-        (fl2width + -125 >= 0) | strength::strong,
-        (fl2height + -21 == 0) | strength::strong,
-        (fl2height + -21 >= 0) | strength::strong,
-        (lb3top + -0 >= 0) | strength::required,
-        (lb3width + -0 >= 0) | strength::required,
-        (fl1left + -0 >= 0) | strength::required,
-        (fl1width + -0 >= 0) | strength::required,
-        (lb1width + -67 >= 0) | strength::strong,
-        (fl2left + -0 >= 0) | strength::required,
-        (lb2width + -66 == 0) | strength::weak,
-        (lb2width + -66 >= 0) | strength::strong,
-        (lb2height + -16 == 0) | strength::strong,
-        (fl1height + -0 >= 0) | strength::required,
-        (fl1top + -0 >= 0) | strength::required,
-        (lb2top + -0 >= 0) | strength::required,
-        (-lb2top + lb3top + -lb2height + -10 == 0) | mmedium,
-        (-lb3top + -lb3height + fl3top + -10 >= 0) | strength::required,
-        (-lb3top + -lb3height + fl3top + -10 == 0) | mmedium,
-        (contents_bottom + -fl3height + -fl3top + -0 == 0) | mmedium,
-        (fl1top + -contents_top + 0 >= 0) | strength::required,
-        (fl1top + -contents_top + 0 == 0) | mmedium,
-        (contents_bottom + -fl3height + -fl3top + -0 >= 0) | strength::required,
-        (-left + -width + contents_right + 10 == 0) | strength::required,
-        (-top + -height + contents_bottom + 10 == 0) | strength::required,
-        (-left + contents_left + -10 == 0) | strength::required,
-        (lb3left + -contents_left + 0 == 0) | mmedium,
-        (fl1left + -midline + 0 == 0) | strength::strong,
-        (fl2left + -midline + 0 == 0) | strength::strong,
-        (ctleft + -midline + 0 == 0) | strength::strong,
-        (fl1top + 0.5 * fl1height + -lb1top + -0.5 * lb1height + 0 == 0) | strength::strong,
-        (lb1left + -contents_left + 0 >= 0) | strength::required,
-        (lb1left + -contents_left + 0 == 0) | mmedium,
-        (-lb1left + fl1left + -lb1width + -10 >= 0) | strength::required,
-        (-lb1left + fl1left + -lb1width + -10 == 0) | mmedium,
-        (-fl1left + contents_right + -fl1width + -0 >= 0) | strength::required,
-        (width + 0 == 0) | strength::medium,
-        (-fl1top + fl2top + -fl1height + -10 >= 0) | strength::required,
-        (-fl1top + fl2top + -fl1height + -10 == 0) | mmedium,
-        (cttop + -fl2top + -fl2height + -10 >= 0) | strength::required,
-        (-ctheight + -cttop + fl3top + -10 >= 0) | strength::required,
-        (contents_bottom + -fl3height + -fl3top + -0 >= 0) | strength::required,
-        (cttop + -fl2top + -fl2height + -10 == 0) | mmedium,
-        (-fl1left + contents_right + -fl1width + -0 == 0) | mmedium,
-        (-lb2top + -0.5 * lb2height + fl2top + 0.5 * fl2height + 0 == 0) | strength::strong,
-        (-contents_left + lb2left + 0 >= 0) | strength::required,
-        (-contents_left + lb2left + 0 == 0) | mmedium,
-        (fl2left + -lb2width + -lb2left + -10 >= 0) | strength::required,
-        (-ctheight + -cttop + fl3top + -10 == 0) | mmedium,
-        (contents_bottom + -fl3height + -fl3top + -0 == 0) | mmedium,
-        (lb1top + -0 >= 0) | strength::required,
-        (lb1width + -0 >= 0) | strength::required,
-        (lb1height + -0 >= 0) | strength::required,
-        (fl2left + -lb2width + -lb2left + -10 == 0) | mmedium,
-        (-fl2left + -fl2width + contents_right + -0 == 0) | mmedium,
-        (-fl2left + -fl2width + contents_right + -0 >= 0) | strength::required,
-        (lb3left + -contents_left + 0 >= 0) | strength::required,
-        (lb1left + -0 >= 0) | strength::required,
-        (0.5 * ctheight + cttop + -lb3top + -0.5 * lb3height + 0 == 0) | strength::strong,
-        (ctleft + -lb3left + -lb3width + -10 >= 0) | strength::required,
-        (-ctwidth + -ctleft + contents_right + -0 >= 0) | strength::required,
-        (ctleft + -lb3left + -lb3width + -10 == 0) | mmedium,
-        (fl3left + -contents_left + 0 >= 0) | strength::required,
-        (fl3left + -contents_left + 0 == 0) | mmedium,
-        (-ctwidth + -ctleft + contents_right + -0 == 0) | mmedium,
-        (-fl3left + contents_right + -fl3width + -0 == 0) | mmedium,
-        (-contents_top + lb1top + 0 >= 0) | strength::required,
-        (-contents_top + lb1top + 0 == 0) | mmedium,
-        (-fl3left + contents_right + -fl3width + -0 >= 0) | strength::required,
-        (lb2top + -lb1top + -lb1height + -10 >= 0) | strength::required,
-        (-lb2top + lb3top + -lb2height + -10 >= 0) | strength::required,
-        (lb2top + -lb1top + -lb1height + -10 == 0) | mmedium,
-        (fl1height + -21 == 0) | strength::strong,
-        (fl1height + -21 >= 0) | strength::strong,
-        (lb2left + -0 >= 0) | strength::required,
-        (lb2height + -16 >= 0) | strength::strong,
-        (fl2top + -0 >= 0) | strength::required,
-        (fl2width + -0 >= 0) | strength::required,
-        (lb1height + -16 >= 0) | strength::strong,
-        (lb1height + -16 == 0) | strength::strong,
-        (fl3width + -125 >= 0) | strength::strong,
-        (fl3height + -21 == 0) | strength::strong,
-        (fl3height + -21 >= 0) | strength::strong,
-        (lb3height + -0 >= 0) | strength::required,
-        (ctwidth + -119 >= 0) | smedium,
-        (lb3width + -24 == 0) | strength::weak,
-        (lb3width + -24 >= 0) | strength::strong,
-        (fl1width + -125 >= 0) | strength::strong,
+    struct Form
+    {
+        Variable width;
+        Variable height;
     };
 
-    for (const auto& constraint : constraints)
-        solver.addConstraint(constraint);
-}
+    void addEditVariable(const Variable &variable, double strength)
+    {
+        edits.emplace_back(variable, strength);
+    }
+
+    void addConstraint(const Constraint &constraint)
+    {
+        constraints.push_back(constraint);
+    }
+
+    std::vector<std::pair<Variable, double>> edits;
+    std::vector<Constraint> constraints;
+};
 
 int main()
 {
@@ -221,4 +79,102 @@ int main()
             solver.updateVariables();
         });
     }
+
+    for (const Size& size : sizes)
+    {
+        std::pair<Variable, double> suggestions[] = {
+            { widthVar, double(size.width) },
+            { heightVar, double(size.height) }
+        };
+
+        ankerl::nanobench::Bench().minEpochIterations(10).run("suggest values " + std::to_string(size.width) + "x" + std::to_string(size.height), [&] {
+            solver.suggestValues(std::begin(suggestions), std::end(suggestions));
+            solver.updateVariables();
+        });
+    }
+
+    // Lay out every width of a resize from 320 to 4000 pixels.
+    solver.suggestValue(heightVar, 600);
+    std::vector<double> values(solver.sweep(widthVar, 320, 4000).variables().size());
+
+    ankerl::nanobench::Bench().minEpochIterations(10).run("suggest widths 320-4000", [&] {
+        for (int width = 320; width <= 4000; ++width)
+        {
+            solver.suggestValue(widthVar, width);
+            solver.updateVariables();
+        }
+    });
+
+    ankerl::nanobench::Bench().minEpochIterations(10).run("sweep widths 320-4000", [&] {
+        Sweep sweep = solver.sweep(widthVar, 320, 4000);
+        for (int width = 320; width <= 4000; ++width)
+            sweep.evaluate(width, values.data());
+        ankerl::nanobench::doNotOptimizeAway(values);
+    });
+
+    // Preview a resize on a clone sharing the rows of the solver.
+    ankerl::nanobench::Bench().minEpochIterations(10).run("clone and suggest value", [&] {
+        std::unique_ptr<Solver> preview = solver.clone();
+        preview->suggestValue(widthVar, 1024);
+        ankerl::nanobench::doNotOptimizeAway(preview);
+    });
+
+    // Try a batch of constraints and undo it.
+    std::vector<Variable> columns(10);
+    std::vector<Constraint> trial;
+    for (std::size_t i = 0; i < columns.size(); ++i)
+    {
+        trial.push_back(columns[i] >= (i == 0 ? Expression(0) : columns[i - 1] + 10));
+        trial.push_back(columns[i] <= widthVar);
+    }
+
+    ankerl::nanobench::Bench().minEpochIterations(10).run("add and remove constraints", [&] {
+        solver.addConstraints(trial.begin(), trial.end());
+        for (const Constraint& constraint : trial)
+            solver.removeConstraint(constraint);
+    });
+
+    ankerl::nanobench::Bench().minEpochIterations(10).run("add constraints and roll back", [&] {
+        solver.beginTransaction();
+        solver.addConstraints(trial.begin(), trial.end());
+        solver.rollback();
+    });
+
+    // Restore the solver from a snapshot instead of building it.
+    std::vector<Variable> variables;
+    std::vector<Constraint> constraints;
+    std::vector<char> snapshot;
+    solver.save(
+        snapshot,
+        [&](const Variable &variable) { variables.push_back(variable); return variables.size() - 1; },
+        [&](const Constraint &constraint) { constraints.push_back(constraint); return constraints.size() - 1; });
+
+    ankerl::nanobench::Bench().minEpochIterations(10).run("loading solver", [&] {
+        Solver restored;
+        restored.load(
+            snapshot.data(), snapshot.size(),
+            [&](std::uint64_t key) { return variables[key]; },
+            [&](std::uint64_t key) { return constraints[key]; });
+        ankerl::nanobench::doNotOptimizeAway(restored);
+    });
+
+    // Lay out a dashboard of independent forms, serially and on a pool.
+    std::vector<Dashboard::Form> forms(16);
+    Dashboard dashboard;
+    for (Dashboard::Form &form : forms)
+        build_solver(dashboard, form.width, form.height);
+
+    WorkStealingPool pool;
+    for (Executor *executor : {static_cast<Executor *>(nullptr), static_cast<Executor *>(&pool)})
+    {
+        std::string name = executor ? " on " + std::to_string(pool.threadCount()) + " threads" : "";
+        ankerl::nanobench::Bench().minEpochIterations(10).run("building dashboard" + name, [&] {
+            Solver solver;
+            solver.setExecutor(executor);
+            for (const auto &edit : dashboard.edits)
+                solver.addEditVariable(edit.first, edit.second);
+            solver.addConstraints(dashboard.constraints.begin(), dashboard.constraints.end());
+            ankerl::nanobench::doNotOptimizeAway(solver);
+        });
+    }
 }
@@ -192,6 +192,21 @@ def bench_update_variables(loops, solver):
     return perf.perf_counter() - t0
 
 
+def bench_update_variables_in_batch(loops, solver):
+    """Suggest new values at once and update variables.
+
+    """
+    t0 = perf.perf_counter()
+    for w, h in [(400, 600), (600, 400), (800, 1200), (1200, 800),
+                (400, 800), (800, 400)]*loops:
+        solver.suggestValues((width, height), (w, h))
+        solver.updateVariables()
+
+    return perf.perf_counter() - t0
+
+
 runner = perf.Runner()
 runner.bench_time_func('kiwi.suggestValue', bench_update_variables,
                        solver, inner_loops=1)
+runner.bench_time_func('kiwi.suggestValues', bench_update_variables_in_batch,
+                       solver, inner_loops=1)
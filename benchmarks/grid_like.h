@@ -0,0 +1,37 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#pragma once
+
+// A large form shared by the benchmarks: n widgets laid out in lines of
+// ten, left to right, each with a preferred width. Every line must fit in a
+// window whose width is edited and which is wide enough for the preferred
+// widths.
+
+#include <vector>
+#include <kiwi/kiwi.h>
+
+template <typename SolverType>
+void build_grid(SolverType& solver, std::vector<kiwi::Variable>& lefts, std::vector<kiwi::Variable>& widths, kiwi::Variable& window)
+{
+    using namespace kiwi;
+
+    const std::size_t line = 10;
+    solver.addEditVariable(window, strength::strong);
+    solver.suggestValue(window, 650);
+    for (std::size_t i = 0; i < lefts.size(); ++i)
+    {
+        solver.addConstraint(widths[i] >= 10);
+        solver.addConstraint((widths[i] == 40 + double(i % 3) * 5) | strength::weak);
+        if (i % line == 0)
+            solver.addConstraint(lefts[i] == 0);
+        else
+            solver.addConstraint(lefts[i] >= lefts[i - 1] + widths[i - 1] + 5);
+        if (i % line == line - 1 || i + 1 == lefts.size())
+            solver.addConstraint(lefts[i] + widths[i] <= window);
+    }
+}
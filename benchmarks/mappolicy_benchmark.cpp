@@ -0,0 +1,85 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Time the enaml like workload and synthetic large systems under each map
+// policy of the solver.
+
+#include <kiwi/kiwi.h>
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include "nanobench.h"
+#include "enaml_like.h"
+#include "grid_like.h"
+
+using namespace kiwi;
+
+template <typename Policy>
+void bench_enaml(const std::string& name)
+{
+    ankerl::nanobench::Bench().run(name + " building enaml solver", [&] {
+        BasicSolver<double, Policy> solver;
+        Variable width("width");
+        Variable height("height");
+        build_solver(solver, width, height);
+        ankerl::nanobench::doNotOptimizeAway(solver);
+    });
+
+    BasicSolver<double, Policy> solver;
+    Variable width("width");
+    Variable height("height");
+    build_solver(solver, width, height);
+    double sizes[] = { 400, 600, 800, 1200 };
+    std::size_t index = 0;
+    ankerl::nanobench::Bench().minEpochIterations(10).run(name + " suggest enaml size", [&] {
+        double size = sizes[index++ % 4];
+        solver.suggestValue(width, size);
+        solver.suggestValue(height, size * 1.5);
+        solver.updateVariables();
+    });
+}
+
+template <typename Policy>
+void bench_large(const std::string& name, std::size_t count)
+{
+    std::vector<Variable> lefts(count);
+    std::vector<Variable> widths(count);
+    Variable window("window");
+    std::string suffix = " " + std::to_string(count) + " widgets";
+
+    ankerl::nanobench::Bench().epochs(3).epochIterations(1).run(name + " building" + suffix, [&] {
+        BasicSolver<double, Policy> solver;
+        build_grid(solver, lefts, widths, window);
+        ankerl::nanobench::doNotOptimizeAway(solver);
+    });
+
+    BasicSolver<double, Policy> solver;
+    build_grid(solver, lefts, widths, window);
+    double size = 650;
+    ankerl::nanobench::Bench().epochs(3).epochIterations(10).run(name + " suggest" + suffix, [&] {
+        size = size > 800 ? 500 : size + 25;
+        solver.suggestValue(window, size);
+        solver.updateVariables();
+    });
+}
+
+template <typename Policy>
+void bench_policy(const std::string& name)
+{
+    bench_enaml<Policy>(name);
+    std::size_t counts[] = { 100, 1000, 5000 };
+    for (std::size_t count : counts)
+        bench_large<Policy>(name, count);
+}
+
+int main()
+{
+    bench_policy<AssocVectorPolicy>("AssocVector");
+    bench_policy<StdMapPolicy>("std::map");
+    bench_policy<HashMapPolicy>("HashMap");
+    bench_policy<BlockMapPolicy>("BlockMap");
+    bench_policy<DefaultMapPolicy>("Default");
+}
@@ -0,0 +1,66 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Time the basis map operations performed by one simplex pivot: find the
+// leaving row, erase it and insert the row under the entering symbol.
+
+#include <kiwi/kiwi.h>
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include "nanobench.h"
+
+using namespace kiwi::impl;
+
+using AssocRowMap = MapType<Symbol, Row*>;
+
+using StdRowMap = std::map<Symbol, Row*>;
+
+using HashRowMap = HashMap<Symbol, Row*, SymbolHash>;
+
+using BlockRowMap = BlockMap<Symbol, Row*>;
+
+template <typename Map>
+void bench_pivots(ankerl::nanobench::Bench& bench, const std::string& name, std::size_t rows)
+{
+    // The basis holds the symbols [1, rows], the parametric symbols are
+    // (rows, 2 * rows]. Each pivot swaps a basic and a parametric symbol.
+    Map map;
+    std::vector<Symbol> basic;
+    std::vector<Symbol> parametric;
+    for (std::size_t i = 1; i <= rows; ++i)
+    {
+        basic.push_back(Symbol(Symbol::Slack, i));
+        parametric.push_back(Symbol(Symbol::Slack, rows + i));
+        map[basic.back()] = nullptr;
+    }
+
+    ankerl::nanobench::Rng rng(42);
+    bench.run(name + " " + std::to_string(rows) + " rows", [&] {
+        std::size_t b = rng.bounded(static_cast<uint32_t>(rows));
+        std::size_t p = rng.bounded(static_cast<uint32_t>(rows));
+        auto it = map.find(basic[b]);
+        Row* row = it->second;
+        map.erase(it);
+        map[parametric[p]] = row;
+        std::swap(basic[b], parametric[p]);
+    });
+}
+
+int main()
+{
+    ankerl::nanobench::Bench bench;
+    bench.title("pivot basis update").unit("pivot").minEpochIterations(1000);
+
+    std::size_t sizes[] = { 1000, 10000, 100000 };
+    for (std::size_t rows : sizes)
+    {
+        bench_pivots<AssocRowMap>(bench, "AssocVector", rows);
+        bench_pivots<StdRowMap>(bench, "std::map", rows);
+        bench_pivots<HashRowMap>(bench, "HashMap", rows);
+        bench_pivots<BlockRowMap>(bench, "BlockMap", rows);
+    }
+}
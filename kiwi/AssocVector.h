@@ -126,6 +126,10 @@ namespace Loki
         : Base(alloc), MyCompare(comp)
         {}
 
+        explicit AssocVector(const A& alloc)
+        : Base(alloc), MyCompare(key_compare())
+        {}
+
         template <class InputIterator>
         AssocVector(InputIterator first, InputIterator last,
             const key_compare& comp = key_compare(),
@@ -136,6 +140,10 @@ namespace Loki
             std::sort(begin(), end(), me);
         }
 
+        AssocVector(const AssocVector& rhs)
+        : Base(rhs), MyCompare(rhs)
+        {}
+
         AssocVector& operator=(const AssocVector& rhs)
         {
             AssocVector(rhs).swap(*this);
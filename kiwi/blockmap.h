@@ -0,0 +1,290 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace kiwi
+{
+
+namespace impl
+{
+
+/* A sorted map stored in a list of small sorted blocks.
+
+This is a two level B-tree: a lookup binary searches the block whose last
+key is not less than the key, then binary searches inside the block. An
+insertion or an erasure only moves the entries of one block, so unlike
+AssocVector the cost of updating a large map does not grow with its size,
+while iterating it remains a scan over contiguous entries.
+
+BEWARE: as with AssocVector, iterators are invalidated by insert and erase
+and value_type is std::pair<K, V> not std::pair<const K, V>.
+
+*/
+template <typename K, typename V, typename C = std::less<K>, typename A = std::allocator<std::pair<K, V>>>
+class BlockMap
+{
+
+    using Block = std::vector<std::pair<K, V>, A>;
+    using BlockAllocator = typename std::allocator_traits<A>::template rebind_alloc<Block>;
+    using BlockList = std::vector<Block, BlockAllocator>;
+
+    // A block is split when it grows past this size.
+    static const std::size_t MaxBlockSize = 64;
+
+    template <typename List, typename Value>
+    class Iterator
+    {
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename std::remove_const<Value>::type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value *;
+        using reference = Value &;
+
+        Iterator() : m_blocks(nullptr), m_block(0), m_index(0) {}
+
+        Iterator(List *blocks, std::size_t block, std::size_t index) : m_blocks(blocks), m_block(block), m_index(index) {}
+
+        // Allow the conversion of an iterator to a const_iterator.
+        template <typename OtherList, typename OtherValue>
+        Iterator(const Iterator<OtherList, OtherValue> &other) : m_blocks(other.m_blocks), m_block(other.m_block), m_index(other.m_index) {}
+
+        reference operator*() const
+        {
+            return (*m_blocks)[m_block][m_index];
+        }
+
+        pointer operator->() const
+        {
+            return &(*m_blocks)[m_block][m_index];
+        }
+
+        Iterator &operator++()
+        {
+            if (++m_index == (*m_blocks)[m_block].size())
+            {
+                ++m_block;
+                m_index = 0;
+            }
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator it(*this);
+            ++*this;
+            return it;
+        }
+
+        friend bool operator==(const Iterator &lhs, const Iterator &rhs)
+        {
+            return lhs.m_block == rhs.m_block && lhs.m_index == rhs.m_index;
+        }
+
+        friend bool operator!=(const Iterator &lhs, const Iterator &rhs)
+        {
+            return !(lhs == rhs);
+        }
+
+    private:
+        template <typename, typename>
+        friend class Iterator;
+
+        friend class BlockMap;
+
+        List *m_blocks;
+        std::size_t m_block;
+        std::size_t m_index;
+    };
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using key_compare = C;
+    using allocator_type = A;
+    using iterator = Iterator<BlockList, value_type>;
+    using const_iterator = Iterator<const BlockList, const value_type>;
+    using size_type = std::size_t;
+
+    explicit BlockMap(const A &alloc = A()) : m_blocks(BlockAllocator(alloc)), m_alloc(alloc), m_size(0) {}
+
+    ~BlockMap() = default;
+
+    iterator begin()
+    {
+        return iterator(&m_blocks, 0, 0);
+    }
+
+    iterator end()
+    {
+        return iterator(&m_blocks, m_blocks.size(), 0);
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(&m_blocks, 0, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(&m_blocks, m_blocks.size(), 0);
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    iterator find(const K &key)
+    {
+        std::size_t block = 0;
+        std::size_t index = 0;
+        if (!locate(key, block, index))
+            return end();
+        return iterator(&m_blocks, block, index);
+    }
+
+    const_iterator find(const K &key) const
+    {
+        std::size_t block = 0;
+        std::size_t index = 0;
+        if (!locate(key, block, index))
+            return end();
+        return const_iterator(&m_blocks, block, index);
+    }
+
+    V &operator[](const K &key)
+    {
+        return insert(value_type(key, V())).first->second;
+    }
+
+    /* Insert the value if its key is not in the map yet.
+
+	Return the iterator to the entry of the key and whether the value
+	has been inserted.
+
+	*/
+    std::pair<iterator, bool> insert(value_type value)
+    {
+        std::size_t block = 0;
+        std::size_t index = 0;
+        if (locate(value.first, block, index))
+            return std::make_pair(iterator(&m_blocks, block, index), false);
+        if (m_blocks.empty())
+            m_blocks.push_back(Block(m_alloc));
+        else if (block == m_blocks.size())
+        {
+            // The key is greater than all the keys of the map.
+            block = m_blocks.size() - 1;
+            index = m_blocks[block].size();
+        }
+        Block &target = m_blocks[block];
+        target.insert(target.begin() + index, std::move(value));
+        ++m_size;
+        if (target.size() > MaxBlockSize)
+        {
+            std::size_t half = target.size() / 2;
+            Block tail(std::make_move_iterator(target.begin() + half),
+                       std::make_move_iterator(target.end()),
+                       m_alloc);
+            target.erase(target.begin() + half, target.end());
+            m_blocks.insert(m_blocks.begin() + block + 1, std::move(tail));
+            if (index >= half)
+            {
+                ++block;
+                index -= half;
+            }
+        }
+        return std::make_pair(iterator(&m_blocks, block, index), true);
+    }
+
+    void erase(iterator it)
+    {
+        Block &target = m_blocks[it.m_block];
+        target.erase(target.begin() + it.m_index);
+        --m_size;
+        if (target.empty())
+        {
+            m_blocks.erase(m_blocks.begin() + it.m_block);
+            return;
+        }
+        // Merge the block with its successor when both became small, so
+        // the number of blocks stays proportional to the size of the map.
+        std::size_t next = it.m_block + 1;
+        if (next < m_blocks.size() && target.size() + m_blocks[next].size() <= MaxBlockSize / 2)
+        {
+            Block &successor = m_blocks[next];
+            target.insert(target.end(),
+                          std::make_move_iterator(successor.begin()),
+                          std::make_move_iterator(successor.end()));
+            m_blocks.erase(m_blocks.begin() + next);
+        }
+    }
+
+    size_type erase(const K &key)
+    {
+        iterator it = find(key);
+        if (it == end())
+            return 0;
+        erase(it);
+        return 1;
+    }
+
+    void clear()
+    {
+        m_blocks.clear();
+        m_size = 0;
+    }
+
+private:
+    /* Find the position of a key.
+
+	Return whether the key is in the map. The block and index are set to
+	the position of the key, or to the position where it should be
+	inserted. The block is the number of blocks if the key is greater
+	than all the keys of the map.
+
+	*/
+    bool locate(const K &key, std::size_t &block, std::size_t &index) const
+    {
+        C compare;
+        auto bit = std::lower_bound(m_blocks.begin(), m_blocks.end(), key,
+                                    [&compare](const Block &b, const K &k) { return compare(b.back().first, k); });
+        block = bit - m_blocks.begin();
+        index = 0;
+        if (bit == m_blocks.end())
+            return false;
+        auto it = std::lower_bound(bit->begin(), bit->end(), key,
+                                   [&compare](const value_type &v, const K &k) { return compare(v.first, k); });
+        index = it - bit->begin();
+        return !compare(key, it->first);
+    }
+
+    BlockList m_blocks;
+    A m_alloc;
+    std::size_t m_size;
+};
+
+} // namespace impl
+
+} // namespace kiwi
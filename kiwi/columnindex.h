@@ -0,0 +1,207 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#pragma once
+#include <algorithm>
+#include <vector>
+#include "memoryresource.h"
+#include "symbol.h"
+
+namespace kiwi
+{
+
+namespace impl
+{
+
+/* The column index of the tableau.
+
+For each parametric symbol, the index holds the list of the basic symbols
+whose row contains that symbol. Recording a change only appends to a list:
+a removed row is appended to a list of removed rows which is subtracted
+from the column when the column is read. The column is sorted when it is
+read, so the pivoting rules break ties by symbol order, independently of
+the history of the tableau.
+
+The columns are stored in a vector indexed by the symbol id, which the
+solver keeps dense by recycling ids, so no lookup is needed to update a
+column when a cell enters or leaves a row.
+
+*/
+class ColumnIndex
+{
+
+public:
+    using RowList = std::vector<Symbol, Allocator<Symbol>>;
+
+    ColumnIndex(MemoryResource *resource = newDeleteResource()) : m_columns(resource), m_empty(resource), m_scratch(resource) {}
+
+    ColumnIndex(const ColumnIndex &other) : m_columns(other.m_columns), m_empty(other.m_empty), m_scratch(other.m_empty) {}
+
+    ~ColumnIndex() = default;
+
+    /* Get the sorted basic symbols of the rows which contain the given
+	symbol.
+
+	*/
+    const RowList &rows(const Symbol &symbol)
+    {
+        if (symbol.id() >= m_columns.size())
+            return m_empty;
+        return normalize(m_columns[symbol.id()]);
+    }
+
+    /* Record that the row of the given basic symbol contains a symbol.
+
+	The row must not already be recorded for the symbol.
+
+	*/
+    void add(const Symbol &symbol, const Symbol &basic)
+    {
+        if (symbol.id() >= m_columns.size())
+            m_columns.resize(symbol.id() + 1, Column(m_empty));
+        Column &column = m_columns[symbol.id()];
+        if (column.sorted == column.rows.size() && (column.rows.empty() || !(basic < column.rows.back())))
+            ++column.sorted;
+        column.rows.push_back(basic);
+    }
+
+    /* Record that the row of the given basic symbol no longer contains
+	a symbol.
+
+	The row must have been recorded for the symbol.
+
+	*/
+    void remove(const Symbol &symbol, const Symbol &basic)
+    {
+        if (symbol.id() >= m_columns.size())
+            return;
+        Column &column = m_columns[symbol.id()];
+        column.removed.push_back(basic);
+        if (column.removed.size() == column.rows.size())
+        {
+            column.rows.clear();
+            column.removed.clear();
+            column.sorted = 0;
+        }
+        else if (column.removed.size() * 2 > column.rows.size())
+            normalize(column);
+    }
+
+    /* Move the sorted row list of the given symbol out of the index.
+
+	*/
+    void take(const Symbol &symbol, RowList &out)
+    {
+        out.clear();
+        if (symbol.id() >= m_columns.size())
+            return;
+        Column &column = m_columns[symbol.id()];
+        out.swap(normalize(column));
+        column.rows.clear();
+        column.sorted = 0;
+    }
+
+    void clear()
+    {
+        m_columns.clear();
+    }
+
+private:
+    ColumnIndex &operator=(const ColumnIndex &);
+
+    struct Column
+    {
+        Column(const RowList &empty) : rows(empty), removed(empty), sorted(0) {}
+
+        RowList rows;
+        RowList removed;
+        std::size_t sorted;  // the length of the sorted prefix of the rows
+    };
+
+    using ColumnList = std::vector<Column, Allocator<Column>>;
+
+    /* Sort the rows of a column and subtract its removed rows.
+
+	A row can be added again after being removed, so the rows and the
+	removed rows are subtracted as multisets.
+
+	*/
+    RowList &normalize(Column &column)
+    {
+        RowList &rows = column.rows;
+        if (column.sorted != rows.size())
+        {
+            // Only the rows added since the last read need sorting, they
+            // are then merged from the back into the sorted prefix.
+            m_scratch.assign(rows.begin() + column.sorted, rows.end());
+            std::sort(m_scratch.begin(), m_scratch.end());
+            std::size_t i = column.sorted;
+            std::size_t j = m_scratch.size();
+            std::size_t w = rows.size();
+            while (j > 0)
+            {
+                if (i > 0 && m_scratch[j - 1] < rows[i - 1])
+                    rows[--w] = rows[--i];
+                else
+                    rows[--w] = m_scratch[--j];
+            }
+            column.sorted = rows.size();
+        }
+        RowList &removed = column.removed;
+        if (removed.empty())
+            return rows;
+        std::sort(removed.begin(), removed.end());
+        auto out = rows.begin();
+        auto it = rows.begin();
+        auto gone = removed.begin();
+        for (; it != rows.end(); ++it)
+        {
+            while (gone != removed.end() && *gone < *it)
+                ++gone;
+            if (gone != removed.end() && *gone == *it)
+                ++gone;
+            else
+                *out++ = *it;
+        }
+        rows.erase(out, rows.end());
+        removed.clear();
+        column.sorted = rows.size();
+        return rows;
+    }
+
+    ColumnList m_columns;
+    RowList m_empty;
+    RowList m_scratch;
+};
+
+/* A row observer which keeps the column index in sync with a row.
+
+*/
+class ColumnObserver
+{
+
+public:
+    ColumnObserver(ColumnIndex &index, const Symbol &basic) : m_index(index), m_basic(basic) {}
+
+    void added(const Symbol &symbol)
+    {
+        m_index.add(symbol, m_basic);
+    }
+
+    void removed(const Symbol &symbol)
+    {
+        m_index.remove(symbol, m_basic);
+    }
+
+private:
+    ColumnIndex &m_index;
+    Symbol m_basic;
+};
+
+} // namespace impl
+
+} // namespace kiwi
@@ -0,0 +1,110 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#pragma once
+#include <algorithm>
+#include <vector>
+#include "memoryresource.h"
+#include "symbol.h"
+
+namespace kiwi
+{
+
+namespace impl
+{
+
+/* The connected components of the tableau.
+
+Two symbols belong to the same component when the rows of the tableau
+link them, directly or through other rows. A pivot only combines rows
+which share a symbol, so only adding a constraint can join components.
+The components are kept as a union-find forest over the symbol ids, with
+union by size and path halving. Removing a constraint may split a
+component, which the forest cannot undo, so the index is then marked
+stale and the solver rebuilds it from its rows when it is next read.
+
+*/
+class ComponentIndex
+{
+
+public:
+    using Id = Symbol::Id;
+
+    ComponentIndex(MemoryResource *resource = newDeleteResource()) : m_parents(resource), m_sizes(resource), m_stale(false) {}
+
+    ~ComponentIndex() = default;
+
+    /* Get the representative id of the component of an id.
+
+    */
+    Id find(Id id)
+    {
+        if (id >= m_parents.size())
+            return id;
+        while (m_parents[id] != id)
+        {
+            m_parents[id] = m_parents[m_parents[id]];
+            id = m_parents[id];
+        }
+        return id;
+    }
+
+    /* Join the components of two ids.
+
+    */
+    void unite(Id first, Id second)
+    {
+        grow(std::max(first, second));
+        first = find(first);
+        second = find(second);
+        if (first == second)
+            return;
+        if (m_sizes[first] < m_sizes[second])
+            std::swap(first, second);
+        m_parents[second] = first;
+        m_sizes[first] += m_sizes[second];
+    }
+
+    bool stale() const
+    {
+        return m_stale;
+    }
+
+    void setStale()
+    {
+        m_stale = true;
+    }
+
+    void clear()
+    {
+        m_parents.clear();
+        m_sizes.clear();
+        m_stale = false;
+    }
+
+private:
+    using IdList = std::vector<Id, Allocator<Id>>;
+
+    void grow(Id id)
+    {
+        Id size = Id(m_parents.size());
+        if (id < size)
+            return;
+        m_parents.resize(id + 1);
+        m_sizes.resize(id + 1, 1);
+        for (Id i = size; i <= id; ++i)
+            m_parents[i] = i;
+    }
+
+    IdList m_parents;
+    IdList m_sizes;
+    bool m_stale;
+};
+
+} // namespace impl
+
+} // namespace kiwi
@@ -6,6 +6,7 @@
 | The full license is in the file LICENSE, distributed with this software.
 |----------------------------------------------------------------------------*/
 #pragma once
+#include <functional>
 #include <map>
 #include <vector>
 #include "expression.h"
@@ -112,6 +113,8 @@ private:
         return lhs.m_data < rhs.m_data;
     }
 
+    friend struct std::hash<Constraint>;
+
     friend bool operator==(const Constraint &lhs, const Constraint &rhs)
     {
         return lhs.m_data == rhs.m_data;
@@ -124,3 +127,18 @@ private:
 };
 
 } // namespace kiwi
+
+namespace std
+{
+
+// Hash a constraint by identity, consistently with its ordering.
+template <>
+struct hash<kiwi::Constraint>
+{
+    std::size_t operator()(const kiwi::Constraint &constraint) const
+    {
+        return std::hash<const void *>()(constraint.m_data.data());
+    }
+};
+
+} // namespace std
@@ -23,7 +23,8 @@ class DebugHelper
 {
 
 public:
-    static void dump(const SolverImpl &solver, std::ostream &out)
+    template <typename T, typename Policy>
+    static void dump(const SolverImpl<T, Policy> &solver, std::ostream &out)
     {
         out << "Objective" << std::endl;
         out << "---------" << std::endl;
@@ -31,7 +32,7 @@ public:
         out << std::endl;
         out << "Tableau" << std::endl;
         out << "-------" << std::endl;
-        dump(solver.m_rows, out);
+        dumpRows(solver.m_rows, out);
         out << std::endl;
         out << "Infeasible" << std::endl;
         out << "----------" << std::endl;
@@ -39,20 +40,21 @@ public:
         out << std::endl;
         out << "Variables" << std::endl;
         out << "---------" << std::endl;
-        dump(solver.m_vars, out);
+        dumpVars(solver.m_vars, out);
         out << std::endl;
         out << "Edit Variables" << std::endl;
         out << "--------------" << std::endl;
-        dump(solver.m_edits, out);
+        dumpEdits(solver.m_edits, out);
         out << std::endl;
         out << "Constraints" << std::endl;
         out << "-----------" << std::endl;
-        dump(solver.m_cns, out);
+        dumpConstraints(solver.m_cns, out);
         out << std::endl;
         out << std::endl;
     }
 
-    static void dump(const SolverImpl::RowMap &rows, std::ostream &out)
+    template <typename RowMap>
+    static void dumpRows(const RowMap &rows, std::ostream &out)
     {
         for (const auto &rowPair : rows)
         {
@@ -62,7 +64,8 @@ public:
         }
     }
 
-    static void dump(const std::vector<Symbol> &symbols, std::ostream &out)
+    template <typename A>
+    static void dump(const std::vector<Symbol, A> &symbols, std::ostream &out)
     {
         for (const auto &symbol : symbols)
         {
@@ -71,7 +74,8 @@ public:
         }
     }
 
-    static void dump(const SolverImpl::VarMap &vars, std::ostream &out)
+    template <typename VarMap>
+    static void dumpVars(const VarMap &vars, std::ostream &out)
     {
         for (const auto &varPair : vars)
         {
@@ -81,24 +85,27 @@ public:
         }
     }
 
-    static void dump(const SolverImpl::CnMap &cns, std::ostream &out)
+    template <typename CnMap>
+    static void dumpConstraints(const CnMap &cns, std::ostream &out)
     {
         for (const auto &cnPair : cns)
             dump(cnPair.first, out);
     }
 
-    static void dump(const SolverImpl::EditMap &edits, std::ostream &out)
+    template <typename EditMap>
+    static void dumpEdits(const EditMap &edits, std::ostream &out)
     {
         for (const auto &editPair : edits)
             out << editPair.first.name() << std::endl;
     }
 
-    static void dump(const Row &row, std::ostream &out)
+    template <typename T>
+    static void dump(const BasicRow<T> &row, std::ostream &out)
     {
-        for (const auto &rowPair : row.cells())
+        for (std::size_t i = 0, n = row.size(); i < n; ++i)
         {
-            out << " + " << rowPair.second << " * ";
-            dump(rowPair.first, out);
+            out << " + " << row.coefficients()[i] << " * ";
+            dump(row.symbols()[i], out);
         }
         out << std::endl;
     }
@@ -159,4 +159,21 @@ private:
     std::string m_msg;
 };
 
+class BadSnapshot : public std::exception
+{
+
+public:
+    BadSnapshot(const char *msg) : m_msg(msg) {}
+
+    ~BadSnapshot() noexcept {}
+
+    const char *what() const noexcept
+    {
+        return m_msg;
+    }
+
+private:
+    const char *m_msg;
+};
+
 } // namespace kiwi
@@ -0,0 +1,208 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kiwi
+{
+
+/* Run the independent tasks of an operation of a solver.
+
+A solver given an executor splits its batch operations into tasks over
+the independent parts of the system. The tasks share no data, so they
+can run concurrently and in any order, and the solver merges their
+results in a fixed order once they are all done.
+
+*/
+class Executor
+{
+
+public:
+    virtual ~Executor() = default;
+
+    /* Run task(0) to task(count - 1) and return once they are all done.
+
+    If tasks throw, the first exception is rethrown once they are done.
+
+    */
+    virtual void run(std::size_t count, const std::function<void(std::size_t)> &task) = 0;
+};
+
+/* An executor running the tasks on a pool of threads.
+
+Each thread of the pool has a queue of tasks. A thread takes the tasks of
+its own queue from the back and, once it is empty, steals the tasks of the
+other queues from the front, so the threads stay busy when the tasks have
+very different sizes. The thread calling run works on the tasks too, so a
+pool of n threads starts n - 1 threads of its own.
+
+*/
+class WorkStealingPool : public Executor
+{
+
+public:
+    explicit WorkStealingPool(std::size_t threads = std::thread::hardware_concurrency())
+        : m_task(nullptr), m_generation(0), m_pending(0), m_stop(false)
+    {
+        threads = std::max<std::size_t>(threads, 1);
+        for (std::size_t i = 0; i < threads; ++i)
+            m_queues.emplace_back(new Queue());
+        for (std::size_t i = 1; i < threads; ++i)
+            m_threads.emplace_back(&WorkStealingPool::work, this, i);
+    }
+
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (std::thread &thread : m_threads)
+            thread.join();
+    }
+
+    /* Get the number of threads working on the tasks, the caller included.
+
+    */
+    std::size_t threadCount() const
+    {
+        return m_queues.size();
+    }
+
+    void run(std::size_t count, const std::function<void(std::size_t)> &task) override
+    {
+        if (count == 0)
+            return;
+        std::lock_guard<std::mutex> running(m_run_mutex);
+        m_task = &task;
+        m_error = nullptr;
+        m_pending = count;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            Queue &queue = *m_queues[i % m_queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(i);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_generation;
+        }
+        m_wake.notify_all();
+        drain(0);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_pending == 0; });
+        m_task = nullptr;
+        if (m_error)
+            std::rethrow_exception(m_error);
+    }
+
+private:
+    WorkStealingPool(const WorkStealingPool &);
+
+    WorkStealingPool &operator=(const WorkStealingPool &);
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+    };
+
+    void work(std::size_t worker)
+    {
+        std::size_t seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this, seen] { return m_stop || m_generation != seen; });
+                if (m_stop)
+                    return;
+                seen = m_generation;
+            }
+            drain(worker);
+        }
+    }
+
+    /* Run tasks until none is left in any queue.
+
+    */
+    void drain(std::size_t worker)
+    {
+        std::size_t index;
+        while (take(worker, index))
+        {
+            try
+            {
+                (*m_task)(index);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_error)
+                    m_error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_pending == 0)
+                m_done.notify_all();
+        }
+    }
+
+    /* Take a task from the back of the own queue, or steal one from the
+    front of another queue.
+
+    */
+    bool take(std::size_t worker, std::size_t &index)
+    {
+        {
+            Queue &queue = *m_queues[worker];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty())
+            {
+                index = queue.tasks.back();
+                queue.tasks.pop_back();
+                return true;
+            }
+        }
+        for (std::size_t i = 1; i < m_queues.size(); ++i)
+        {
+            Queue &queue = *m_queues[(worker + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty())
+            {
+                index = queue.tasks.front();
+                queue.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::mutex m_run_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const std::function<void(std::size_t)> *m_task;
+    std::exception_ptr m_error;
+    std::size_t m_generation;
+    std::size_t m_pending;
+    bool m_stop;
+};
+
+} // namespace kiwi
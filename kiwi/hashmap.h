@@ -0,0 +1,262 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "symbol.h"
+
+namespace kiwi
+{
+
+namespace impl
+{
+
+/* Hash a symbol by its id.
+
+The ids are small consecutive integers, so they are spread with a
+Fibonacci multiplication before being reduced to a table index.
+
+*/
+struct SymbolHash
+{
+    std::size_t operator()(const Symbol &symbol) const
+    {
+        return static_cast<std::size_t>((symbol.id() * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+};
+
+/* Hash a key with std::hash and spread the result.
+
+The standard hash of a pointer is usually the pointer itself, whose low
+bits are always zero, so it is spread the same way as the symbol ids.
+
+*/
+template <typename K>
+struct SpreadHash
+{
+    std::size_t operator()(const K &key) const
+    {
+        return static_cast<std::size_t>((std::uint64_t(std::hash<K>()(key)) * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+};
+
+/* Compare keys for equality using their ordering.
+
+Variables build a constraint from operator==, so the maps keyed by
+variables test the equivalence of the keys instead.
+
+*/
+template <typename K>
+struct EquivalentKey
+{
+    bool operator()(const K &lhs, const K &rhs) const
+    {
+        return !(lhs < rhs) && !(rhs < lhs);
+    }
+};
+
+/* An open-addressing hash map with dense storage.
+
+The entries are stored contiguously in insertion order (erasing moves the
+last entry into the hole), so iterating the map is a linear scan over a
+vector, just as with AssocVector. The lookup table uses linear probing with
+backward shift deletion, so no tombstones accumulate over the pivots.
+
+BEWARE: as with AssocVector, iterators are invalidated by insert and erase.
+
+*/
+template <typename K, typename V, typename H, typename A = std::allocator<std::pair<K, V>>, typename E = std::equal_to<K>>
+class HashMap
+{
+
+    using SlotAllocator = typename std::allocator_traits<A>::template rebind_alloc<std::uint32_t>;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using allocator_type = A;
+    using container_type = std::vector<value_type, A>;
+    using iterator = typename container_type::iterator;
+    using const_iterator = typename container_type::const_iterator;
+    using size_type = std::size_t;
+
+    explicit HashMap(const A &alloc = A()) : m_entries(alloc), m_slots(SlotAllocator(alloc)), m_mask(0) {}
+
+    ~HashMap() = default;
+
+    iterator begin()
+    {
+        return m_entries.begin();
+    }
+
+    iterator end()
+    {
+        return m_entries.end();
+    }
+
+    const_iterator begin() const
+    {
+        return m_entries.begin();
+    }
+
+    const_iterator end() const
+    {
+        return m_entries.end();
+    }
+
+    size_type size() const
+    {
+        return m_entries.size();
+    }
+
+    bool empty() const
+    {
+        return m_entries.empty();
+    }
+
+    iterator find(const K &key)
+    {
+        std::size_t slot = findSlot(key);
+        if (slot == npos)
+            return m_entries.end();
+        return m_entries.begin() + (m_slots[slot] - 1);
+    }
+
+    const_iterator find(const K &key) const
+    {
+        std::size_t slot = findSlot(key);
+        if (slot == npos)
+            return m_entries.end();
+        return m_entries.begin() + (m_slots[slot] - 1);
+    }
+
+    V &operator[](const K &key)
+    {
+        return insert(value_type(key, V())).first->second;
+    }
+
+    /* Insert the value if its key is not in the map yet.
+
+	Return the iterator to the entry of the key and whether the value
+	has been inserted.
+
+	*/
+    std::pair<iterator, bool> insert(value_type value)
+    {
+        if ((m_entries.size() + 1) * 2 > m_slots.size())
+            rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+        std::size_t slot = hashSlot(value.first);
+        while (m_slots[slot] != 0)
+        {
+            std::size_t index = m_slots[slot] - 1;
+            if (E()(m_entries[index].first, value.first))
+                return std::make_pair(m_entries.begin() + index, false);
+            slot = (slot + 1) & m_mask;
+        }
+        m_entries.push_back(std::move(value));
+        m_slots[slot] = static_cast<std::uint32_t>(m_entries.size());
+        return std::make_pair(m_entries.end() - 1, true);
+    }
+
+    void erase(iterator it)
+    {
+        std::size_t index = it - m_entries.begin();
+        eraseSlot(findSlot(it->first));
+        std::size_t last = m_entries.size() - 1;
+        if (index != last)
+        {
+            // Move the last entry into the hole and repoint its slot.
+            m_slots[findSlot(m_entries[last].first)] = static_cast<std::uint32_t>(index + 1);
+            m_entries[index] = std::move(m_entries[last]);
+        }
+        m_entries.pop_back();
+    }
+
+    size_type erase(const K &key)
+    {
+        iterator it = find(key);
+        if (it == m_entries.end())
+            return 0;
+        erase(it);
+        return 1;
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+        std::fill(m_slots.begin(), m_slots.end(), 0);
+    }
+
+private:
+    static const std::size_t npos = std::size_t(-1);
+
+    std::size_t hashSlot(const K &key) const
+    {
+        return H()(key) & m_mask;
+    }
+
+    std::size_t findSlot(const K &key) const
+    {
+        if (m_slots.empty())
+            return npos;
+        std::size_t slot = hashSlot(key);
+        while (m_slots[slot] != 0)
+        {
+            if (E()(m_entries[m_slots[slot] - 1].first, key))
+                return slot;
+            slot = (slot + 1) & m_mask;
+        }
+        return npos;
+    }
+
+    void eraseSlot(std::size_t slot)
+    {
+        // Backward shift deletion: pull the following entries of the
+        // probe sequence back so that no lookup chain is broken.
+        std::size_t hole = slot;
+        std::size_t next = (hole + 1) & m_mask;
+        while (m_slots[next] != 0)
+        {
+            std::size_t home = hashSlot(m_entries[m_slots[next] - 1].first);
+            if (((next - home) & m_mask) >= ((next - hole) & m_mask))
+            {
+                m_slots[hole] = m_slots[next];
+                hole = next;
+            }
+            next = (next + 1) & m_mask;
+        }
+        m_slots[hole] = 0;
+    }
+
+    void rehash(std::size_t capacity)
+    {
+        m_slots.assign(capacity, 0);
+        m_mask = capacity - 1;
+        for (std::size_t i = 0; i < m_entries.size(); ++i)
+        {
+            std::size_t slot = hashSlot(m_entries[i].first);
+            while (m_slots[slot] != 0)
+                slot = (slot + 1) & m_mask;
+            m_slots[slot] = static_cast<std::uint32_t>(i + 1);
+        }
+    }
+
+    container_type m_entries;
+    std::vector<std::uint32_t, SlotAllocator> m_slots;
+    std::size_t m_mask;
+};
+
+} // namespace impl
+
+} // namespace kiwi
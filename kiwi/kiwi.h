@@ -9,10 +9,14 @@
 #include "constraint.h"
 #include "debug.h"
 #include "errors.h"
+#include "executor.h"
 #include "expression.h"
+#include "memoryresource.h"
 #include "shareddata.h"
+#include "snapshot.h"
 #include "solver.h"
 #include "strength.h"
+#include "sweep.h"
 #include "symbolics.h"
 #include "term.h"
 #include "variable.h"
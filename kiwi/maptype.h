@@ -11,6 +11,10 @@
 #include <memory>
 #include <utility>
 #include "AssocVector.h"
+#include "blockmap.h"
+#include "hashmap.h"
+#include "memoryresource.h"
+#include "symbol.h"
 
 namespace kiwi
 {
@@ -25,13 +29,70 @@ template <
     typename A = std::allocator<std::pair<K, V>>>
 using MapType = Loki::AssocVector<K, V, C, A>;
 
-// template<
-// 	typename K,
-// 	typename V,
-// 	typename C = std::less<K>,
-// 	typename A = std::allocator< std::pair<const K, V> > >
-// using MapType = std::map<K, V, C, A>;
-
 } // namespace impl
 
+/*
+Map policies
+============
+A map policy selects the containers used by a solver. `Map<K, V>` holds the
+constraints, the variables and the edit variables, `SymbolMap<V>` holds the
+rows of the tableau keyed by their basic symbol. All the maps draw their
+memory from the memory resource of the solver.
+
+The choice only affects the speed of the solver, never its results: the
+sorted containers suit small systems best, the hash maps large ones.
+
+*/
+
+// Sorted vectors for all the maps.
+struct AssocVectorPolicy
+{
+    template <typename K, typename V>
+    using Map = Loki::AssocVector<K, V, std::less<K>, impl::Allocator<std::pair<K, V>>>;
+
+    template <typename V>
+    using SymbolMap = Map<impl::Symbol, V>;
+};
+
+// Red-black trees for all the maps.
+struct StdMapPolicy
+{
+    template <typename K, typename V>
+    using Map = std::map<K, V, std::less<K>, impl::Allocator<std::pair<const K, V>>>;
+
+    template <typename V>
+    using SymbolMap = Map<impl::Symbol, V>;
+};
+
+// Open-addressing hash maps for all the maps.
+struct HashMapPolicy
+{
+    template <typename K, typename V>
+    using Map = impl::HashMap<K, V, impl::SpreadHash<K>, impl::Allocator<std::pair<K, V>>, impl::EquivalentKey<K>>;
+
+    template <typename V>
+    using SymbolMap = impl::HashMap<impl::Symbol, V, impl::SymbolHash, impl::Allocator<std::pair<impl::Symbol, V>>>;
+};
+
+// Two level B-trees of sorted blocks for all the maps.
+struct BlockMapPolicy
+{
+    template <typename K, typename V>
+    using Map = impl::BlockMap<K, V, std::less<K>, impl::Allocator<std::pair<K, V>>>;
+
+    template <typename V>
+    using SymbolMap = Map<impl::Symbol, V>;
+};
+
+// Sorted vectors for the maps of the user objects and a hash map for the
+// rows, which are updated by every pivot.
+struct DefaultMapPolicy
+{
+    template <typename K, typename V>
+    using Map = AssocVectorPolicy::Map<K, V>;
+
+    template <typename V>
+    using SymbolMap = HashMapPolicy::SymbolMap<V>;
+};
+
 } // namespace kiwi
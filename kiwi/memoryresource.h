@@ -0,0 +1,196 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#pragma once
+#include <cstddef>
+#include <new>
+
+#if defined(_MSVC_LANG) && _MSVC_LANG > __cplusplus
+#define KIWI_CPLUSPLUS _MSVC_LANG
+#else
+#define KIWI_CPLUSPLUS __cplusplus
+#endif
+
+#if KIWI_CPLUSPLUS >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define KIWI_HAS_PMR 1
+#endif
+#endif
+
+/*
+Implementation note
+===================
+The C++ codebase targets C++11, which has no std::pmr. MemoryResource mirrors
+the interface of std::pmr::memory_resource and every allocation made by a
+solver (rows, cell arrays, maps, pools) goes through the resource given at
+construction time. When compiled as C++17, PmrMemoryResource adapts any
+std::pmr::memory_resource so monotonic or pooled arenas can be used directly.
+*/
+
+namespace kiwi
+{
+
+class MemoryResource
+{
+
+public:
+    MemoryResource() = default;
+
+    virtual ~MemoryResource() {} // LCOV_EXCL_LINE
+
+    void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        return do_allocate(bytes, alignment);
+    }
+
+    void deallocate(void *p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        do_deallocate(p, bytes, alignment);
+    }
+
+    bool is_equal(const MemoryResource &other) const noexcept
+    {
+        return this == &other || do_is_equal(other);
+    }
+
+protected:
+    virtual void *do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+
+    virtual void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) = 0;
+
+    virtual bool do_is_equal(const MemoryResource &other) const noexcept
+    {
+        return this == &other;
+    }
+};
+
+namespace impl
+{
+
+class NewDeleteResource : public MemoryResource
+{
+
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t) override
+    {
+        return ::operator new(bytes);
+    }
+
+    void do_deallocate(void *p, std::size_t, std::size_t) override
+    {
+        ::operator delete(p);
+    }
+};
+
+} // namespace impl
+
+/* The resource used when none is given: global operator new and delete.
+
+*/
+inline MemoryResource *newDeleteResource()
+{
+    static impl::NewDeleteResource resource;
+    return &resource;
+}
+
+#ifdef KIWI_HAS_PMR
+
+/* Adapt a std::pmr::memory_resource to the MemoryResource interface.
+
+The adapted resource must outlive the adapter.
+
+*/
+class PmrMemoryResource : public MemoryResource
+{
+
+public:
+    explicit PmrMemoryResource(std::pmr::memory_resource *resource) : m_resource(resource) {}
+
+    std::pmr::memory_resource *resource() const
+    {
+        return m_resource;
+    }
+
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        return m_resource->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+    {
+        m_resource->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const MemoryResource &other) const noexcept override
+    {
+        const PmrMemoryResource *pmr = dynamic_cast<const PmrMemoryResource *>(&other);
+        return pmr && m_resource->is_equal(*pmr->m_resource);
+    }
+
+private:
+    std::pmr::memory_resource *m_resource;
+};
+
+#endif // KIWI_HAS_PMR
+
+namespace impl
+{
+
+/* A standard allocator which draws its memory from a MemoryResource.
+
+This is the C++11 counterpart of std::pmr::polymorphic_allocator. Copies
+of a container keep the resource of the original.
+
+*/
+template <typename T>
+class Allocator
+{
+
+public:
+    using value_type = T;
+
+    Allocator(MemoryResource *resource = newDeleteResource()) noexcept : m_resource(resource) {}
+
+    template <typename U>
+    Allocator(const Allocator<U> &other) noexcept : m_resource(other.resource()) {}
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(m_resource->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n)
+    {
+        m_resource->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    MemoryResource *resource() const
+    {
+        return m_resource;
+    }
+
+private:
+    MemoryResource *m_resource;
+};
+
+template <typename T, typename U>
+bool operator==(const Allocator<T> &lhs, const Allocator<U> &rhs)
+{
+    return lhs.resource()->is_equal(*rhs.resource());
+}
+
+template <typename T, typename U>
+bool operator!=(const Allocator<T> &lhs, const Allocator<U> &rhs)
+{
+    return !(lhs == rhs);
+}
+
+} // namespace impl
+
+} // namespace kiwi
@@ -6,7 +6,12 @@
 | The full license is in the file LICENSE, distributed with this software.
 |----------------------------------------------------------------------------*/
 #pragma once
-#include "maptype.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include "memoryresource.h"
+#include "simd.h"
 #include "symbol.h"
 #include "util.h"
 
@@ -16,36 +21,164 @@ namespace kiwi
 namespace impl
 {
 
-class Row
+/* A cell observer which ignores all notifications.
+
+Row mutators accept an observer which is told about every symbol which
+enters or leaves the row. The solver uses this to keep its column index
+in sync with the tableau.
+
+*/
+struct NullCellObserver
+{
+    void added(const Symbol &) {}
+
+    void removed(const Symbol &) {}
+};
+
+/* A row of the tableau.
+
+The coefficients and the constant of the row are of the scalar type T of
+the solver, see ScalarTraits.
+
+*/
+template <typename T>
+class BasicRow
 {
 
 public:
-    using CellMap = MapType<Symbol, double>;
+    /* The cells of a row are stored as two parallel arrays sorted by
+	symbol: the symbols and their coefficients. This keeps the hot
+	loops (merge, scale, prune) on contiguous memory.
+
+	*/
+    using SymbolVector = std::vector<Symbol, Allocator<Symbol>>;
 
-    Row() : Row(0.0) {}
+    using CoeffVector = std::vector<T, Allocator<T>>;
 
-    Row(double constant) : m_constant(constant) {}
+    BasicRow() : BasicRow(T(0)) {}
 
-    Row(const Row &other) = default;
+    BasicRow(T constant, MemoryResource *resource = newDeleteResource()) : m_symbols(resource),
+                                                                           m_coeffs(resource),
+                                                                           m_constant(constant),
+                                                                           m_owners(1) {}
+
+    /* A copy of a row has a single owner.
+
+	*/
+    BasicRow(const BasicRow &other) : m_symbols(other.m_symbols),
+                                      m_coeffs(other.m_coeffs),
+                                      m_constant(other.m_constant),
+                                      m_owners(1) {}
 
-    ~Row() = default;
+    ~BasicRow() = default;
 
-    const CellMap &cells() const
+    /* Copy the cells and the constant of a row, the owners are kept.
+
+	*/
+    BasicRow &operator=(const BasicRow &other)
+    {
+        m_symbols = other.m_symbols;
+        m_coeffs = other.m_coeffs;
+        m_constant = other.m_constant;
+        return *this;
+    }
+
+    const SymbolVector &symbols() const
+    {
+        return m_symbols;
+    }
+
+    const CoeffVector &coefficients() const
+    {
+        return m_coeffs;
+    }
+
+    std::size_t size() const
     {
-        return m_cells;
+        return m_symbols.size();
     }
 
-    double constant() const
+    bool empty() const
+    {
+        return m_symbols.empty();
+    }
+
+    T constant() const
     {
         return m_constant;
     }
 
+    /* Replace the cells and the constant of the row with arrays of cells
+	sorted by symbol, such as the cells of a row read from a snapshot.
+
+	*/
+    void assign(const void *symbols, const void *coefficients, std::size_t size, T constant)
+    {
+        m_symbols.resize(size);
+        m_coeffs.resize(size);
+        if (size != 0)
+        {
+            std::memcpy(static_cast<void *>(m_symbols.data()), symbols, size * sizeof(Symbol));
+            std::memcpy(static_cast<void *>(m_coeffs.data()), coefficients, size * sizeof(T));
+        }
+        m_constant = constant;
+    }
+
+    /* Test whether the row is held by several solvers.
+
+	The clones of a solver share its rows, and a shared row is copied by
+	a solver before it modifies it. The owners are counted atomically, but
+	a solver and its clones still share the handles of the variables and
+	constraints, whose reference counts are not, so they must not be used
+	from different threads at the same time.
+
+	*/
+    bool shared() const
+    {
+        return m_owners.load(std::memory_order_acquire) > 1;
+    }
+
+    /* Add an owner to the row.
+
+	*/
+    void retain()
+    {
+        m_owners.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /* Remove an owner from the row.
+
+	Return true if the owner was the last one, which can then reuse or
+	destroy the row.
+
+	*/
+    bool release()
+    {
+        if (m_owners.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return false;
+        m_owners.store(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /* Remove all cells and set the constant of the row.
+
+	The cell arrays keep their capacity so that the row can be reused
+	without reallocating.
+
+	*/
+    void clear(T constant = T(0))
+    {
+        m_symbols.clear();
+        m_coeffs.clear();
+        m_constant = constant;
+    }
+
     /* Add a constant value to the row constant.
 
 	The new value of the constant is returned.
 
 	*/
-    double add(double value)
+    T add(T value)
     {
         return m_constant += value;
     }
@@ -57,10 +190,19 @@ public:
 	is zero, the symbol will be removed from the row.
 
 	*/
-    void insert(const Symbol &symbol, double coefficient = 1.0)
+    void insert(const Symbol &symbol, T coefficient = T(1))
     {
-        if (nearZero(m_cells[symbol] += coefficient))
-            m_cells.erase(symbol);
+        std::size_t index = lowerBound(symbol);
+        if (index != m_symbols.size() && m_symbols[index] == symbol)
+        {
+            if (nearZero(m_coeffs[index] += coefficient))
+                eraseAt(index);
+        }
+        else if (!nearZero(coefficient))
+        {
+            m_symbols.insert(m_symbols.begin() + index, symbol);
+            m_coeffs.insert(m_coeffs.begin() + index, coefficient);
+        }
     }
 
     /* Insert a row into this row with a given coefficient.
@@ -69,17 +211,81 @@ public:
 	the coefficient and added to this row. Any cell with a resulting
 	coefficient of zero will be removed from the row.
 
+	The cells are combined with a linear merge of the two sorted
+	arrays, performed in place from the back so that no temporary
+	storage is needed.
+
 	*/
-    void insert(const Row &other, double coefficient = 1.0)
+    void insert(const BasicRow &other, T coefficient = T(1))
+    {
+        NullCellObserver observer;
+        insert(other, coefficient, observer);
+    }
+
+    template <typename Observer>
+    void insert(const BasicRow &other, T coefficient, Observer &observer)
     {
         m_constant += other.m_constant * coefficient;
 
-        for (const auto & cellPair : other.m_cells)
+        const std::size_t n = m_symbols.size();
+        const std::size_t m = other.m_symbols.size();
+        if (m == 0)
+            return;
+
+        // Count the cells of the union to size the arrays exactly.
+        std::size_t total = n + m;
+        for (std::size_t i = 0, j = 0; i < n && j < m;)
+        {
+            if (m_symbols[i] < other.m_symbols[j])
+                ++i;
+            else if (other.m_symbols[j] < m_symbols[i])
+                ++j;
+            else
+            {
+                --total;
+                ++i;
+                ++j;
+            }
+        }
+
+        m_symbols.resize(total);
+        m_coeffs.resize(total);
+        Symbol *syms = m_symbols.data();
+        T *coeffs = m_coeffs.data();
+        const Symbol *osyms = other.m_symbols.data();
+        const T *ocoeffs = other.m_coeffs.data();
+
+        // Merge from the back. Once the other row is exhausted, the
+        // remaining cells of this row are already in place.
+        std::size_t i = n;
+        std::size_t j = m;
+        std::size_t w = total;
+        while (j > 0)
         {
-            double coeff = cellPair.second * coefficient;
-            if (nearZero(m_cells[cellPair.first] += coeff))
-                m_cells.erase(cellPair.first);
+            --w;
+            if (i > 0 && osyms[j - 1] < syms[i - 1])
+            {
+                --i;
+                syms[w] = syms[i];
+                coeffs[w] = coeffs[i];
+            }
+            else if (i > 0 && syms[i - 1] == osyms[j - 1])
+            {
+                --i;
+                --j;
+                syms[w] = syms[i];
+                coeffs[w] = coeffs[i] + ocoeffs[j] * coefficient;
+            }
+            else
+            {
+                --j;
+                syms[w] = osyms[j];
+                coeffs[w] = ocoeffs[j] * coefficient;
+                observer.added(syms[w]);
+            }
         }
+
+        prune(observer);
     }
 
     /* Remove the given symbol from the row.
@@ -87,9 +293,19 @@ public:
 	*/
     void remove(const Symbol &symbol)
     {
-        auto it = m_cells.find(symbol);
-        if (it != m_cells.end())
-            m_cells.erase(it);
+        NullCellObserver observer;
+        remove(symbol, observer);
+    }
+
+    template <typename Observer>
+    void remove(const Symbol &symbol, Observer &observer)
+    {
+        std::size_t index = lowerBound(symbol);
+        if (index != m_symbols.size() && m_symbols[index] == symbol)
+        {
+            eraseAt(index);
+            observer.removed(symbol);
+        }
     }
 
     /* Reverse the sign of the constant and all cells in the row.
@@ -98,8 +314,7 @@ public:
     void reverseSign()
     {
         m_constant = -m_constant;
-        for (auto &cellPair : m_cells)
-            cellPair.second = -cellPair.second;
+        simd::scale(m_coeffs.data(), m_coeffs.size(), T(-1));
     }
 
     /* Solve the row for the given symbol.
@@ -115,11 +330,11 @@ public:
 	*/
     void solveFor(const Symbol &symbol)
     {
-        double coeff = -1.0 / m_cells[symbol];
-        m_cells.erase(symbol);
+        std::size_t index = lowerBound(symbol);
+        T coeff = T(-1) / m_coeffs[index];
+        eraseAt(index);
         m_constant *= coeff;
-        for (auto &cellPair : m_cells)
-            cellPair.second *= coeff;
+        simd::scale(m_coeffs.data(), m_coeffs.size(), coeff);
     }
 
     /* Solve the row for the given symbols.
@@ -135,7 +350,7 @@ public:
 	*/
     void solveFor(const Symbol &lhs, const Symbol &rhs)
     {
-        insert(lhs, -1.0);
+        insert(lhs, T(-1));
         solveFor(rhs);
     }
 
@@ -144,12 +359,12 @@ public:
 	If the symbol does not exist in the row, zero will be returned.
 
 	*/
-    double coefficientFor(const Symbol &symbol) const
+    T coefficientFor(const Symbol &symbol) const
     {
-        CellMap::const_iterator it = m_cells.find(symbol);
-        if (it == m_cells.end())
-            return 0.0;
-        return it->second;
+        std::size_t index = lowerBound(symbol);
+        if (index == m_symbols.size() || !(m_symbols[index] == symbol))
+            return T(0);
+        return m_coeffs[index];
     }
 
     /* Substitute a symbol with the data from another row.
@@ -161,22 +376,84 @@ public:
 	If the symbol does not exist in the row, this is a no-op.
 
 	*/
-    void substitute(const Symbol &symbol, const Row &row)
+    void substitute(const Symbol &symbol, const BasicRow &row)
+    {
+        NullCellObserver observer;
+        substitute(symbol, row, observer);
+    }
+
+    template <typename Observer>
+    void substitute(const Symbol &symbol, const BasicRow &row, Observer &observer)
     {
-        auto it = m_cells.find(symbol);
-        if (it != m_cells.end())
+        std::size_t index = lowerBound(symbol);
+        if (index != m_symbols.size() && m_symbols[index] == symbol)
         {
-            double coefficient = it->second;
-            m_cells.erase(it);
-            insert(row, coefficient);
+            T coefficient = m_coeffs[index];
+            eraseAt(index);
+            observer.removed(symbol);
+            insert(row, coefficient, observer);
         }
     }
 
+    /* Replace each symbol of the row with the result of a mapping.
+
+	The mapping must preserve the order of the symbols, so the cells
+	stay sorted without being moved.
+
+	*/
+    template <typename Mapping>
+    void renumber(Mapping mapping)
+    {
+        for (Symbol &symbol : m_symbols)
+            symbol = mapping(symbol);
+    }
+
 private:
-    CellMap m_cells;
-    double m_constant;
+    std::size_t lowerBound(const Symbol &symbol) const
+    {
+        return std::lower_bound(m_symbols.begin(), m_symbols.end(), symbol) - m_symbols.begin();
+    }
+
+    void eraseAt(std::size_t index)
+    {
+        m_symbols.erase(m_symbols.begin() + index);
+        m_coeffs.erase(m_coeffs.begin() + index);
+    }
+
+    /* Remove the cells with a near zero coefficient.
+
+	*/
+    template <typename Observer>
+    void prune(Observer &observer)
+    {
+        const std::size_t n = m_coeffs.size();
+        std::size_t w = simd::findNearZero(m_coeffs.data(), n);
+        if (w == n)
+            return;
+        observer.removed(m_symbols[w]);
+        for (std::size_t r = w + 1; r < n; ++r)
+        {
+            if (!nearZero(m_coeffs[r]))
+            {
+                m_symbols[w] = m_symbols[r];
+                m_coeffs[w] = m_coeffs[r];
+                ++w;
+            }
+            else
+                observer.removed(m_symbols[r]);
+        }
+        m_symbols.resize(w);
+        m_coeffs.resize(w);
+    }
+
+    SymbolVector m_symbols;
+    CoeffVector m_coeffs;
+    T m_constant;
+    std::atomic<unsigned> m_owners;
 };
 
+using Row = BasicRow<double>;
+
 } // namespace impl
 
 } // namespace kiwi
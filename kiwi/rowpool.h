@@ -0,0 +1,128 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#pragma once
+#include <memory>
+#include <vector>
+#include "memoryresource.h"
+#include "row.h"
+
+namespace kiwi
+{
+
+namespace impl
+{
+
+/* A free list of rows.
+
+Released rows are cleared but keep the capacity of their cell arrays, so
+a solver which repeatedly rebuilds systems of a similar size stops
+allocating once the pool is warm. The pool owns the free rows and destroys
+them when it is destroyed. The rows and their cells are allocated from
+the memory resource of the pool.
+
+*/
+template <typename T>
+class BasicRowPool
+{
+
+public:
+    using Row = BasicRow<T>;
+
+    /* Return a row to the pool it was acquired from on destruction.
+
+	*/
+    struct Releaser
+    {
+        Releaser(BasicRowPool *pool = nullptr) : m_pool(pool) {}
+
+        void operator()(Row *row) const
+        {
+            m_pool->release(row);
+        }
+
+        BasicRowPool *m_pool;
+    };
+
+    using Ptr = std::unique_ptr<Row, Releaser>;
+
+    BasicRowPool(MemoryResource *resource = newDeleteResource()) : m_resource(resource), m_free(resource) {}
+
+    ~BasicRowPool()
+    {
+        for (Row *row : m_free)
+            destroy(row);
+    }
+
+    MemoryResource *resource() const
+    {
+        return m_resource;
+    }
+
+    /* Get an empty row with the given constant.
+
+	*/
+    Row *acquire(T constant = T(0))
+    {
+        if (m_free.empty())
+            return create(constant);
+        Row *row = m_free.back();
+        m_free.pop_back();
+        row->clear(constant);
+        return row;
+    }
+
+    /* Get a row holding a copy of the given row.
+
+	*/
+    Row *acquire(const Row &other)
+    {
+        Row *row = acquire();
+        *row = other;
+        return row;
+    }
+
+    /* Get an owning handle which releases the row to this pool.
+
+	*/
+    Ptr own(Row *row)
+    {
+        return Ptr(row, Releaser(this));
+    }
+
+    /* Give a row back to the pool.
+
+	*/
+    void release(Row *row)
+    {
+        m_free.push_back(row);
+    }
+
+private:
+    BasicRowPool(const BasicRowPool &);
+
+    BasicRowPool &operator=(const BasicRowPool &);
+
+    Row *create(T constant)
+    {
+        void *memory = m_resource->allocate(sizeof(Row), alignof(Row));
+        return new (memory) Row(constant, m_resource);
+    }
+
+    void destroy(Row *row)
+    {
+        row->~BasicRow();
+        m_resource->deallocate(row, sizeof(Row), alignof(Row));
+    }
+
+    MemoryResource *m_resource;
+    std::vector<Row *, Allocator<Row *>> m_free;
+};
+
+} // namespace impl
+
+} // namespace kiwi
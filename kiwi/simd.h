@@ -0,0 +1,243 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#pragma once
+#include <cstddef>
+#include "util.h"
+
+/*
+Implementation note
+===================
+The kernels below operate on the contiguous coefficient arrays of a Row. The
+x86-64 builds dispatch at runtime between an SSE2 path (always available on
+x86-64) and an AVX2 path selected with cpuid, for float and double rows.
+Defining KIWI_NO_SIMD forces the portable scalar path. All paths perform the
+exact same IEEE operations, so the solver results do not depend on the
+selected path.
+*/
+
+#if !defined(KIWI_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define KIWI_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define KIWI_TARGET_AVX2
+#else
+#define KIWI_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace kiwi
+{
+
+namespace impl
+{
+
+namespace simd
+{
+
+template <typename T>
+inline void scaleScalar(T *data, std::size_t count, T factor)
+{
+    for (std::size_t i = 0; i < count; ++i)
+        data[i] *= factor;
+}
+
+template <typename T>
+inline std::size_t findNearZeroScalar(const T *data, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (nearZero(data[i]))
+            return i;
+    }
+    return count;
+}
+
+#ifdef KIWI_SIMD_X86
+
+inline void scaleSSE2(double *data, std::size_t count, double factor)
+{
+    const __m128d f = _mm_set1_pd(factor);
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+        _mm_storeu_pd(data + i, _mm_mul_pd(_mm_loadu_pd(data + i), f));
+    scaleScalar(data + i, count - i, factor);
+}
+
+inline std::size_t findNearZeroSSE2(const double *data, std::size_t count)
+{
+    const __m128d sign = _mm_set1_pd(-0.0);
+    const __m128d eps = _mm_set1_pd(ScalarTraits<double>::epsilon());
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128d abs = _mm_andnot_pd(sign, _mm_loadu_pd(data + i));
+        if (_mm_movemask_pd(_mm_cmplt_pd(abs, eps)))
+            break;
+    }
+    return i + findNearZeroScalar(data + i, count - i);
+}
+
+inline void scaleSSE2(float *data, std::size_t count, float factor)
+{
+    const __m128 f = _mm_set1_ps(factor);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), f));
+    scaleScalar(data + i, count - i, factor);
+}
+
+inline std::size_t findNearZeroSSE2(const float *data, std::size_t count)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 eps = _mm_set1_ps(ScalarTraits<float>::epsilon());
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 abs = _mm_andnot_ps(sign, _mm_loadu_ps(data + i));
+        if (_mm_movemask_ps(_mm_cmplt_ps(abs, eps)))
+            break;
+    }
+    return i + findNearZeroScalar(data + i, count - i);
+}
+
+KIWI_TARGET_AVX2 inline void scaleAVX2(double *data, std::size_t count, double factor)
+{
+    const __m256d f = _mm256_set1_pd(factor);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm256_storeu_pd(data + i, _mm256_mul_pd(_mm256_loadu_pd(data + i), f));
+    scaleScalar(data + i, count - i, factor);
+}
+
+KIWI_TARGET_AVX2 inline std::size_t findNearZeroAVX2(const double *data, std::size_t count)
+{
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d eps = _mm256_set1_pd(ScalarTraits<double>::epsilon());
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d abs = _mm256_andnot_pd(sign, _mm256_loadu_pd(data + i));
+        if (_mm256_movemask_pd(_mm256_cmp_pd(abs, eps, _CMP_LT_OQ)))
+            break;
+    }
+    return i + findNearZeroScalar(data + i, count - i);
+}
+
+KIWI_TARGET_AVX2 inline void scaleAVX2(float *data, std::size_t count, float factor)
+{
+    const __m256 f = _mm256_set1_ps(factor);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), f));
+    scaleScalar(data + i, count - i, factor);
+}
+
+KIWI_TARGET_AVX2 inline std::size_t findNearZeroAVX2(const float *data, std::size_t count)
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 eps = _mm256_set1_ps(ScalarTraits<float>::epsilon());
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 abs = _mm256_andnot_ps(sign, _mm256_loadu_ps(data + i));
+        if (_mm256_movemask_ps(_mm256_cmp_ps(abs, eps, _CMP_LT_OQ)))
+            break;
+    }
+    return i + findNearZeroScalar(data + i, count - i);
+}
+
+inline bool cpuHasAVX2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    // The OS must save the ymm registers (OSXSAVE + AVX state enabled).
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+        return false;
+    if ((_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif // KIWI_SIMD_X86
+
+/* The kernels for the coefficients of type T.
+
+Only float and double have vector kernels, a float vector holds twice as
+many coefficients as a double one. The other types use the scalar path.
+
+*/
+template <typename T>
+struct Kernels
+{
+    void (*scale)(T *, std::size_t, T);
+    std::size_t (*findNearZero)(const T *, std::size_t);
+
+    static const Kernels &get()
+    {
+        static const Kernels k = {scaleScalar<T>, findNearZeroScalar<T>};
+        return k;
+    }
+};
+
+#ifdef KIWI_SIMD_X86
+
+template <>
+inline const Kernels<double> &Kernels<double>::get()
+{
+    static const Kernels k = cpuHasAVX2()
+                                 ? Kernels{scaleAVX2, findNearZeroAVX2}
+                                 : Kernels{scaleSSE2, findNearZeroSSE2};
+    return k;
+}
+
+template <>
+inline const Kernels<float> &Kernels<float>::get()
+{
+    static const Kernels k = cpuHasAVX2()
+                                 ? Kernels{scaleAVX2, findNearZeroAVX2}
+                                 : Kernels{scaleSSE2, findNearZeroSSE2};
+    return k;
+}
+
+#endif // KIWI_SIMD_X86
+
+/* Multiply every value of the array by the given factor.
+
+*/
+template <typename T>
+inline void scale(T *data, std::size_t count, T factor)
+{
+    Kernels<T>::get().scale(data, count, factor);
+}
+
+/* Return the index of the first near zero value of the array.
+
+If no value is near zero, count is returned.
+
+*/
+template <typename T>
+inline std::size_t findNearZero(const T *data, std::size_t count)
+{
+    return Kernels<T>::get().findNearZero(data, count);
+}
+
+} // namespace simd
+
+} // namespace impl
+
+} // namespace kiwi
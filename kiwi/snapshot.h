@@ -0,0 +1,166 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "errors.h"
+#include "symbol.h"
+
+namespace kiwi
+{
+
+namespace impl
+{
+
+/* The header of a snapshot of the state of a solver.
+
+A snapshot is the header followed by sections of fixed size records in
+the native byte order, each record starting on 8 bytes. It can be read
+in place from a mapped file: the cells of a row are copied with a single
+memcpy and only the variables and the constraints are looked up by key.
+A snapshot is only loaded by a solver of the same format version, byte
+order and scalar type.
+
+The sections follow in this order:
+
+- the free ids, each as an 8 byte id;
+- the variables, each as a key and a symbol;
+- the constraints, each as a key, a marker and an other symbol;
+- the edit variables, each as the key of the variable, a marker, an
+  other symbol, a strength and the suggested value;
+- the objective then the rows of the tableau, each as a basic symbol, a
+  number of cells and a constant, followed by the symbols then the
+  coefficients of the cells.
+
+*/
+struct SnapshotHeader
+{
+    static const std::uint32_t Version = 1;
+
+    static const std::uint32_t ByteOrder = 0x01020304;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t scalarSize;
+    std::uint32_t reserved;
+    std::uint64_t idTick;
+    std::uint64_t freeIds;
+    std::uint64_t variables;
+    std::uint64_t constraints;
+    std::uint64_t edits;
+    std::uint64_t rows;
+
+    static SnapshotHeader create(std::size_t scalar)
+    {
+        SnapshotHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "KIWISNAP", sizeof(header.magic));
+        header.version = Version;
+        header.byteOrder = ByteOrder;
+        header.scalarSize = std::uint32_t(scalar);
+        return header;
+    }
+
+    void check(std::size_t scalar) const
+    {
+        if (std::memcmp(magic, "KIWISNAP", sizeof(magic)) != 0)
+            throw BadSnapshot("The data is not a snapshot of a solver.");
+        if (version != Version)
+            throw BadSnapshot("The snapshot has an unsupported version.");
+        if (byteOrder != ByteOrder)
+            throw BadSnapshot("The snapshot has a different byte order.");
+        if (scalarSize != std::uint32_t(scalar))
+            throw BadSnapshot("The snapshot has a different scalar type.");
+    }
+};
+
+static_assert(sizeof(SnapshotHeader) % 8 == 0, "the header should keep the records aligned");
+
+/* Append the records of a snapshot to a buffer.
+
+*/
+class SnapshotWriter
+{
+
+public:
+    explicit SnapshotWriter(std::vector<char> &buffer) : m_buffer(buffer) {}
+
+    template <typename U>
+    void write(const U &value)
+    {
+        writeBytes(&value, sizeof(U));
+    }
+
+    void writeBytes(const void *data, std::size_t size)
+    {
+        const char *bytes = static_cast<const char *>(data);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+    }
+
+    /* Pad the buffer to the start of the next record.
+
+    */
+    void align()
+    {
+        m_buffer.resize((m_buffer.size() + 7) & ~std::size_t(7), 0);
+    }
+
+private:
+    std::vector<char> &m_buffer;
+};
+
+/* Read the records of a snapshot in place.
+
+The reader throws BadSnapshot rather than read past the end of the data.
+
+*/
+class SnapshotReader
+{
+
+public:
+    SnapshotReader(const char *data, std::size_t size) : m_data(data), m_size(size), m_offset(0) {}
+
+    template <typename U>
+    U read()
+    {
+        U value;
+        std::memcpy(static_cast<void *>(&value), take(1, sizeof(U)), sizeof(U));
+        return value;
+    }
+
+    /* Get the bytes of an array of count items of the given size.
+
+    */
+    const char *take(std::uint64_t count, std::size_t size)
+    {
+        if (count > (m_size - m_offset) / size)
+            throw BadSnapshot("The snapshot is truncated.");
+        const char *bytes = m_data + m_offset;
+        m_offset += std::size_t(count) * size;
+        return bytes;
+    }
+
+    void align()
+    {
+        std::size_t padding = ((m_offset + 7) & ~std::size_t(7)) - m_offset;
+        if (padding != 0)
+            take(padding, 1);
+    }
+
+private:
+    const char *m_data;
+    std::size_t m_size;
+    std::size_t m_offset;
+};
+
+} // namespace impl
+
+} // namespace kiwi
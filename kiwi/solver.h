@@ -6,24 +6,61 @@
 | The full license is in the file LICENSE, distributed with this software.
 |----------------------------------------------------------------------------*/
 #pragma once
+#include <memory>
+#include <utility>
+#include <vector>
 #include "constraint.h"
 #include "debug.h"
+#include "executor.h"
+#include "memoryresource.h"
 #include "solverimpl.h"
 #include "strength.h"
+#include "sweep.h"
 #include "variable.h"
 
 
 namespace kiwi
 {
 
-class Solver
+/* The constraint solver.
+
+The scalar type is the type of the coefficients of the tableau: float,
+double or long double. A float solver halves the memory of the tableau
+and suits layouts which only need a pixel precision, the strengths are
+then packed in narrower tiers, see strength::create.
+
+The map policy selects the containers used by the solver, see maptype.h.
+The results of the solver do not depend on the policy, only its speed.
+
+*/
+template <typename T = double, typename Policy = DefaultMapPolicy>
+class BasicSolver
 {
 
 public:
 
-	Solver() = default;
+	BasicSolver() = default;
 
-	~Solver() = default;
+	/* Create a solver drawing all its memory from the given resource.
+
+	The rows, their cells and all the internal maps of the solver are
+	allocated from the resource, which must outlive the solver.
+
+	*/
+	explicit BasicSolver( MemoryResource* resource ) : m_impl( resource ) {}
+
+#ifdef KIWI_HAS_PMR
+	/* Create a solver drawing all its memory from a std::pmr resource.
+
+	This allows to use a monotonic or pooled arena owned by the caller,
+	which must outlive the solver.
+
+	*/
+	explicit BasicSolver( std::pmr::memory_resource* resource ) :
+		m_resource( new PmrMemoryResource( resource ) ), m_impl( m_resource.get() ) {}
+#endif
+
+	~BasicSolver() = default;
 
 	/* Add a constraint to the solver.
 
@@ -41,6 +78,30 @@ public:
 		m_impl.addConstraint( constraint );
 	}
 
+	/* Add a range of constraints to the solver.
+
+	The constraints are inserted in the tableau first and the solver is
+	optimized once, which is much faster than adding them one by one.
+	If a constraint cannot be added, the constraints before it remain
+	in the solver and the exception holds the offending constraint.
+	With an executor, see setExecutor, the constraints touching
+	independent parts of the system are added concurrently.
+
+	Throws
+	------
+	DuplicateConstraint
+		A given constraint has already been added to the solver.
+
+	UnsatisfiableConstraint
+		A given constraint is required and cannot be satisfied.
+
+	*/
+	template <typename InputIt>
+	void addConstraints( InputIt first, InputIt last )
+	{
+		m_impl.addConstraints( first, last );
+	}
+
 	/* Remove a constraint from the solver.
 
 	Throws
@@ -54,6 +115,24 @@ public:
 		m_impl.removeConstraint( constraint );
 	}
 
+	/* Remove a range of constraints from the solver.
+
+	The effects and rows of all the constraints are removed in a single
+	sweep and the solver is optimized once. If a constraint is unknown,
+	no constraint is removed.
+
+	Throws
+	------
+	UnknownConstraint
+		A given constraint has not been added to the solver.
+
+	*/
+	template <typename InputIt>
+	void removeConstraints( InputIt first, InputIt last )
+	{
+		m_impl.removeConstraints( first, last );
+	}
+
 	/* Test whether a constraint has been added to the solver.
 
 	*/
@@ -120,6 +199,144 @@ public:
 		m_impl.suggestValue( variable, value );
 	}
 
+	/* Suggest values for a range of edit variables.
+
+	The range holds pairs of an edit variable and its suggested value,
+	for instance a std::vector<std::pair<Variable, double>>. The system
+	is dual optimized once for all the suggestions.
+
+	Throws
+	------
+	UnknownEditVariable
+		A given edit variable has not been added to the solver. The
+		suggestions which precede it are kept.
+
+	*/
+	template <typename InputIt>
+	void suggestValues( InputIt first, InputIt last )
+	{
+		m_impl.suggestValues( first, last );
+	}
+
+	/* Set whether the dual optimization of suggestions is deferred.
+
+	In the deferred mode, the suggestions only accumulate the infeasible
+	rows and a single dual optimization runs before the variables are
+	updated or the system is modified. This suits handlers which suggest
+	several values in a row, for instance a position and a size.
+
+	*/
+	void setDeferSuggestions( bool defer )
+	{
+		m_impl.setDeferSuggestions( defer );
+	}
+
+	/* Test whether the dual optimization of suggestions is deferred.
+
+	*/
+	bool deferSuggestions() const
+	{
+		return m_impl.deferSuggestions();
+	}
+
+	/* Set the executor which solves the independent parts of the system
+	concurrently.
+
+	With an executor, addConstraints and the dual optimization run after
+	suggestions split their work over the parts of the system which share
+	no constraint, for instance the panels of a dashboard. The executor
+	runs the parts concurrently and they are joined before the call
+	returns, so the variables are updated as usual. A batch added on the
+	executor draws fresh symbol ids, and its parts are pivoted exactly as
+	the whole batch would be with those ids. The serial solver reuses the
+	ids of removed constraints instead, so after removals a system with
+	several optimal solutions may settle on another one than without an
+	executor. WorkStealingPool is an executor on a pool of threads. A null
+	executor, the default, solves serially. The executor must outlive its
+	use by the solver.
+
+	*/
+	void setExecutor( Executor* executor )
+	{
+		m_impl.setExecutor( executor );
+	}
+
+	/* Get the executor of the solver, null if it solves serially.
+
+	*/
+	Executor* executor() const
+	{
+		return m_impl.executor();
+	}
+
+	/* Compute the derivatives of the variables with respect to the value
+	suggested for an edit variable.
+
+	The derivatives list holds a pair of a variable and its derivative
+	for each variable which moves with the edit variable. They are read
+	from the current state of the solver, without solving, and hold as
+	long as the suggestions do not make the solver change its basis.
+	This lets an animation extrapolate the values of the variables, or
+	find the items to redraw, without suggesting a value for each frame.
+
+	Throws
+	------
+	UnknownEditVariable
+		The given edit variable has not been added to the solver.
+
+	*/
+	void sensitivity( const Variable& variable, std::vector<std::pair<Variable, double>>& derivatives )
+	{
+		m_impl.sensitivity( variable, derivatives );
+	}
+
+	/* Solve the system over a range of values of an edit variable.
+
+	The values of the variables are piecewise linear in the value of an
+	edit variable. The returned sweep holds the breakpoints between the
+	low and high values and the values and slopes of all the variables of
+	the solver on each segment, so the solution for any value of the
+	range is computed without the solver, see Sweep::evaluate. The solver
+	is left solved for the value suggested before the sweep.
+
+	Throws
+	------
+	UnknownEditVariable
+		The given edit variable has not been added to the solver.
+
+	InternalSolverError
+		The sweep made more degenerate pivots at one value than the
+		solver has rows. The solver is left solved as before the sweep.
+
+	*/
+	Sweep sweep( const Variable& variable, double lo, double hi )
+	{
+		return m_impl.sweep( variable, lo, hi );
+	}
+
+	/* Count the independent parts of the system.
+
+	Two variables are in the same part when the constraints link them,
+	directly or through other variables, so changing the constraints or
+	the suggested values of one part leaves the other parts untouched.
+	A variable without any constraint is a part of its own.
+
+	*/
+	std::size_t componentCount()
+	{
+		return m_impl.componentCount();
+	}
+
+	/* Test whether two variables are in the same part of the system.
+
+	A variable which is not in the solver is in no part.
+
+	*/
+	bool connected( const Variable& first, const Variable& second )
+	{
+		return m_impl.connected( first, second );
+	}
+
 	/* Update the values of the external solver variables.
 
 	*/
@@ -128,6 +345,208 @@ public:
 		m_impl.updateVariables();
 	}
 
+	/* Update the values of the variables changed since the last update.
+
+	Only the variables whose rows were touched by the solver are looked
+	up. The variables whose value moved by more than the epsilon are
+	written and returned in the changed list, the others keep their last
+	written value. This lets a user interface relayout only the items
+	which actually moved.
+
+	*/
+	void updateChangedVariables( std::vector<Variable>& changed, double epsilon = 0.0 )
+	{
+		m_impl.updateChangedVariables( changed, epsilon );
+	}
+
+	/* Write the current values of a range of variables to a buffer.
+
+	The buffer must hold a value per variable. The values are read from
+	the solver, a variable unknown to the solver is zero.
+
+	*/
+	template <typename InputIt>
+	void exportValues( InputIt first, InputIt last, double* out )
+	{
+		m_impl.exportValues( first, last, out );
+	}
+
+	/* Give a variable a slot in the value array of the solver.
+
+	The value array is refreshed by each update of the variables, so a
+	renderer can read the values of the slotted variables as one flat
+	array, see valueSlots. The returned slot is stable until it is
+	removed. The variable is added to the solver if needed. Resetting
+	the solver removes all the slots.
+
+	*/
+	std::size_t addValueSlot( const Variable& variable )
+	{
+		return m_impl.addValueSlot( variable );
+	}
+
+	/* Free a slot of the value array.
+
+	The slot holds zero until it is reused for another variable.
+
+	*/
+	void removeValueSlot( std::size_t slot )
+	{
+		m_impl.removeValueSlot( slot );
+	}
+
+	/* Get the value array of the solver.
+
+	The array holds valueSlotCount values. It can be reallocated when a
+	slot is added.
+
+	*/
+	const double* valueSlots() const
+	{
+		return m_impl.valueSlots();
+	}
+
+	/* Get the number of slots of the value array, including free ones.
+
+	*/
+	std::size_t valueSlotCount() const
+	{
+		return m_impl.valueSlotCount();
+	}
+
+	/* Set whether the variables pull their values from the solver.
+
+	In the pull mode, updateVariables takes a constant time: each
+	variable reads its value from the tableau when it is first accessed
+	after an update and caches it until the next update. This suits
+	large systems of which only a few variables are read after each
+	update. Leaving the pull mode, resetting or destroying the solver
+	detaches its variables, which keep the values of the current
+	solution.
+
+	Reading a variable which was not read since the last update runs the
+	dual optimization of the suggestions deferred since then, see
+	setDeferSuggestions, so Variable::value can throw the errors of the
+	solver in the pull mode.
+
+	*/
+	void setPullValues( bool pull )
+	{
+		m_impl.setPullValues( pull );
+	}
+
+	/* Test whether the variables pull their values from the solver.
+
+	*/
+	bool pullValues() const
+	{
+		return m_impl.pullValues();
+	}
+
+	/* Create a copy of the solver.
+
+	The copy shares the rows of the tableau with the solver, so cloning
+	costs a copy of the maps of the solver and each of the two solvers
+	only copies the rows it modifies afterwards. This makes it cheap to
+	try a speculative layout, such as a drag preview, on a clone which is
+	then dropped or kept. The copy uses the memory resource of the solver.
+
+	The variables are shared by the two solvers, updating the variables
+	of the clone writes their values. exportValues and the value slots
+	read the values of a solver without writing the variables. The clone
+	does not pull the values of the variables, see setPullValues. As they
+	share the variables and the constraints, a solver and its clones must
+	be used from one thread at a time.
+
+	*/
+	std::unique_ptr<BasicSolver> clone() const
+	{
+		return std::unique_ptr<BasicSolver>( new BasicSolver( *this ) );
+	}
+
+	/* Begin a transaction.
+
+	The changes made to the solver until the transaction is committed or
+	rolled back can be undone at once, for instance to try adding a batch
+	of constraints. The solver keeps a log of the rows, constraints and
+	edit variables changed in the transaction, each row being saved the
+	first time it changes. The transactions can be nested. The solver
+	is not compacted while a transaction is open.
+
+	*/
+	void beginTransaction()
+	{
+		m_impl.beginTransaction();
+	}
+
+	/* Keep the changes made since the innermost transaction began.
+
+	*/
+	void commit()
+	{
+		m_impl.commit();
+	}
+
+	/* Undo the changes made since the innermost transaction began.
+
+	The saved rows are put back in the tableau, without removing the
+	added constraints one by one or pivoting. The constraints, the edit
+	variables, the suggested values and the value slots are restored.
+	The variables keep their values until they are updated, the variables
+	which changed in the transaction are reported as changed by
+	updateChangedVariables.
+
+	*/
+	void rollback()
+	{
+		m_impl.rollback();
+	}
+
+	/* Get the number of open transactions.
+
+	*/
+	std::size_t transactionDepth() const
+	{
+		return m_impl.transactionDepth();
+	}
+
+	/* Write the state of the solver to a buffer.
+
+	The snapshot holds the tableau, the constraints, the edit variables
+	with their suggested values and the symbols of the variables, in a
+	versioned binary format, see snapshot.h. The variables and the
+	constraints are written as the integer keys returned by varKey and
+	cnKey, such as their index in the lists of the application. The
+	edit constraints are not given to cnKey.
+
+	*/
+	template <typename VarKey, typename CnKey>
+	void save( std::vector<char>& buffer, VarKey varKey, CnKey cnKey )
+	{
+		m_impl.save( buffer, varKey, cnKey );
+	}
+
+	/* Replace the state of the solver with a snapshot written by save.
+
+	The variables and constraints are bound to the handles returned by
+	variableFor and constraintFor for their keys, for instance those of
+	a new process. The data is read in place, so it can be a mapped
+	file, and the solver is ready for suggestions without solving the
+	system again. The records are checked as they are read, and an
+	invalid snapshot leaves the solver empty.
+
+	Throws
+	------
+	BadSnapshot
+		The data is not a valid snapshot for this solver.
+
+	*/
+	template <typename VarFor, typename CnFor>
+	void load( const char* data, std::size_t size, VarFor variableFor, CnFor constraintFor )
+	{
+		m_impl.load( data, size, variableFor, constraintFor );
+	}
+
 	/* Reset the solver to the empty starting condition.
 
 	This method resets the internal solver state to the empty starting
@@ -142,6 +561,19 @@ public:
 		m_impl.reset();
 	}
 
+	/* Renumber the symbols of the solver into a dense range.
+
+	The ids of the internal symbols are recycled when constraints are
+	removed, but some can be lost over a long session, for instance to
+	unsatisfiable constraints. Compacting gives the live symbols
+	consecutive ids without changing the solution.
+
+	*/
+	void compact()
+	{
+		m_impl.compact();
+	}
+
 	/* Dump a representation of the solver internals to stdout.
 
 	*/
@@ -166,13 +598,52 @@ public:
 		return debug::dumps( m_impl );
 	}
 
+protected:
+
+	BasicSolver( const BasicSolver& other ) : m_resource( other.m_resource ), m_impl( other.m_impl ) {}
+
 private:
 
-	Solver( const Solver& );
+	BasicSolver& operator=( const BasicSolver& );
 
-	Solver& operator=( const Solver& );
+	std::shared_ptr<MemoryResource> m_resource;  // shared with the clones
+	impl::SolverImpl<T, Policy> m_impl;
+};
+
+
+/* The solver computing with doubles and the default map policy.
+
+It is a class rather than an alias so that it can be forward declared.
+
+*/
+class Solver : public BasicSolver<>
+{
+
+public:
+
+	Solver() = default;
+
+	explicit Solver( MemoryResource* resource ) : BasicSolver( resource ) {}
+
+#ifdef KIWI_HAS_PMR
+	explicit Solver( std::pmr::memory_resource* resource ) : BasicSolver( resource ) {}
+#endif
+
+	~Solver() = default;
+
+	/* Create a copy of the solver, see BasicSolver::clone.
+
+	*/
+	std::unique_ptr<Solver> clone() const
+	{
+		return std::unique_ptr<Solver>( new Solver( *this ) );
+	}
 
-	impl::SolverImpl m_impl;
+private:
+
+	Solver( const Solver& other ) : BasicSolver( other ) {}
+
+	Solver& operator=( const Solver& );
 };
 
 } // namespace kiwi
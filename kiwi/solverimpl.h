@@ -7,14 +7,28 @@
 |----------------------------------------------------------------------------*/
 #pragma once
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
 #include <limits>
 #include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
+#include "columnindex.h"
+#include "componentindex.h"
 #include "constraint.h"
 #include "errors.h"
+#include "executor.h"
 #include "expression.h"
+#include "hashmap.h"
 #include "maptype.h"
+#include "memoryresource.h"
 #include "row.h"
+#include "rowpool.h"
+#include "snapshot.h"
+#include "sweep.h"
 #include "symbol.h"
 #include "term.h"
 #include "util.h"
@@ -27,30 +41,143 @@ namespace kiwi
 namespace impl
 {
 
-class SolverImpl
+/* The implementation of the solver.
+
+The tableau is computed with the scalar type T, see ScalarTraits, while
+the variables, terms and strengths exchanged with the user are doubles.
+The containers of the solver are selected by the map policy, see maptype.h.
+
+*/
+template <typename T = double, typename Policy = DefaultMapPolicy>
+class SolverImpl : public Variable::Resolver
 {
 	friend class DebugHelper;
 
+	using Row = BasicRow<T>;
+
+	using RowPool = BasicRowPool<T>;
+
 	struct Tag
 	{
 		Symbol marker;
 		Symbol other;
 	};
 
+	/* A basic row which moves with an edit variable.
+
+	The constant of the row changes by the factor times the change of
+	the value suggested for the edit variable.
+
+	*/
+	struct Response
+	{
+		Symbol basic;
+		Row* row;
+		T factor;
+	};
+
+	using ResponseList = std::vector<Response, Allocator<Response>>;
+
 	struct EditInfo
 	{
+		EditInfo( MemoryResource* resource ) : response( resource ), version( 0 ), level( 0 ) {}
+
 		Tag tag;
 		Constraint constraint;
 		double constant;
+		ResponseList response;  // valid while the version is the basis version
+		std::size_t version;
+		std::size_t level;  // the transaction which last logged the edit
+	};
+
+	using VarMap = typename Policy::template Map<Variable, Symbol>;
+
+	using RowMap = typename Policy::template SymbolMap<Row*>;
+
+	using CnMap = typename Policy::template Map<Constraint, Tag>;
+
+	using EditMap = typename Policy::template Map<Variable, EditInfo>;
+
+	using SymbolVarMap = typename Policy::template SymbolMap<Variable>;
+
+	using SymbolList = std::vector<Symbol, Allocator<Symbol>>;
+
+	using IdList = std::vector<Symbol::Id, Allocator<Symbol::Id>>;
+
+	using FlagList = std::vector<char, Allocator<char>>;
+
+	using ValueList = std::vector<double, Allocator<double>>;
+
+	using SlotList = std::vector<std::size_t, Allocator<std::size_t>>;
+
+	using TagList = std::vector<std::pair<Constraint, Tag>, Allocator<std::pair<Constraint, Tag>>>;
+
+	/* The first change of the row of a basic symbol in a transaction.
+
+	The row is the original row, or null if the symbol was not basic. It
+	is owned by the log until the transaction ends.
+
+	*/
+	struct RowChange
+	{
+		Symbol basic;
+		Row* row;
+		std::size_t level;  // the transaction which logged the original row
+	};
+
+	struct CnChange
+	{
+		Constraint constraint;
+		Tag tag;
+		bool removed;
+	};
+
+	struct EditChange
+	{
+		enum Kind { Added, Removed, Suggested };
+
+		Variable variable;
+		Tag tag;
+		Constraint constraint;
+		double constant;    // the previous constant
+		std::size_t level;  // the previous level of the edit
+		Kind kind;
 	};
 
-	using VarMap = MapType<Variable, Symbol>;
+	using LevelList = std::vector<std::size_t, Allocator<std::size_t>>;
 
-	using RowMap = MapType<Symbol, Row*>;
+	using VarList = std::vector<Variable, Allocator<Variable>>;
 
-	using CnMap = MapType<Constraint, Tag>;
+	/* The undo log of an open transaction.
 
-	using EditMap = MapType<Variable, EditInfo>;
+	*/
+	struct Transaction
+	{
+		explicit Transaction( MemoryResource* resource ) :
+			rows( resource ),
+			constraints( resource ),
+			edits( resource ),
+			variables( resource ),
+			released( resource ),
+			free_ids( resource ),
+			slot_symbols( resource ),
+			free_slots( resource ),
+			objective( nullptr ),
+			id_tick( 0 ) {}
+
+		std::vector<RowChange, Allocator<RowChange>> rows;
+		std::vector<CnChange, Allocator<CnChange>> constraints;
+		std::vector<EditChange, Allocator<EditChange>> edits;
+		VarList variables;   // the variables given a symbol
+		IdList released;     // the ids freed, reused once committed
+		IdList free_ids;
+		SymbolList slot_symbols;
+		SlotList free_slots;
+		Row* objective;
+		Symbol::Id id_tick;
+	};
+
+	using TransactionList = std::vector<Transaction, Allocator<Transaction>>;
 
 	struct DualOptimizeGuard
 	{
@@ -59,15 +186,158 @@ class SolverImpl
 		SolverImpl& m_impl;
 	};
 
+	/* Draw fresh ids for the symbols of a batch run on the executor.
+
+	While a batch is open, a new symbol takes the next unused id rather
+	than a released one, and the ids released are only returned to the
+	free list when the batch closes. The ids drawn by a batch thus follow
+	the order of its constraints, whatever ids were released before it,
+	so the independent parts of a batch can be solved apart and give the
+	same tableau as the batch added serially. Without an executor the
+	batches reuse the released ids, see newSymbol.
+
+	*/
+	struct BatchGuard
+	{
+		BatchGuard( SolverImpl& impl ) : m_impl( impl ) { m_impl.m_batch = true; }
+		~BatchGuard()
+		{
+			m_impl.m_batch = false;
+			m_impl.m_free_ids.insert( m_impl.m_free_ids.end(), m_impl.m_batch_released.begin(), m_impl.m_batch_released.end() );
+			m_impl.m_batch_released.clear();
+		}
+		SolverImpl& m_impl;
+	};
+
+	using CnList = std::vector<Constraint, Allocator<Constraint>>;
+
+	/* An independent part of the tableau, solved apart by a task.
+
+	The rows, objective cells and variables of the part are gathered from
+	the solver before the tasks run. A task copies them into a solver of
+	its own, giving the symbols the ids 1 to n in their order, so that the
+	part is pivoted exactly as in the whole tableau. The part allocates
+	from the global heap, as the memory resource of the solver may not be
+	thread safe.
+
+	*/
+	struct Part
+	{
+		Part() : failed( false ) {}
+
+		std::vector<std::pair<Symbol, const Row*>> rows;
+		std::vector<std::pair<Symbol, T>> objective;
+		std::vector<std::pair<Variable, Symbol>> vars;
+		std::vector<Symbol> infeasible;
+		std::vector<std::size_t> constraints;  // the indices in the batch
+		std::vector<Symbol::Id> ids;           // the id of local symbol i is ids[ i - 1 ]
+		std::vector<Symbol::Id> fresh;         // the ids of the symbols drawn by the part
+		std::vector<Symbol::Id> released;      // the local ids released by the part
+		std::vector<std::pair<Symbol::Id, std::size_t>> drawn;  // per constraint, the count of ids drawn and the released ids so far
+		std::unique_ptr<SolverImpl> impl;
+		bool failed;
+	};
+
+	using PartList = std::vector<Part>;
+
+	using RootMap = std::unordered_map<Symbol::Id, std::size_t>;
+
 public:
 
-	SolverImpl() : m_objective( new Row() ), m_id_tick( 1 ) {}
+	/* Create a solver drawing all its memory from the given resource.
+
+	The resource must outlive the solver.
+
+	*/
+	explicit SolverImpl( MemoryResource* resource = newDeleteResource() ) :
+		m_pool( resource ),
+		m_cns( resource ),
+		m_rows( resource ),
+		m_columns( resource ),
+		m_column_scratch( resource ),
+		m_components( resource ),
+		m_vars( resource ),
+		m_symbol_vars( resource ),
+		m_edits( resource ),
+		m_infeasible_rows( resource ),
+		m_objective( m_pool.own( m_pool.acquire() ) ),
+		m_artificial( nullptr, typename RowPool::Releaser( &m_pool ) ),
+		m_free_ids( resource ),
+		m_changed( resource ),
+		m_changed_flags( resource ),
+		m_slot_symbols( resource ),
+		m_slot_values( resource ),
+		m_free_slots( resource ),
+		m_transactions( resource ),
+		m_row_levels( resource ),
+		m_batch_released( resource ),
+		m_executor( nullptr ),
+		m_id_tick( 1 ),
+		m_basis_version( 1 ),
+		m_epoch( 0 ),
+		m_defer_suggestions( false ),
+		m_pull_values( false ),
+		m_batch( false ) {}
+
+	/* Create a copy of a solver which shares its rows.
+
+	Only the containers of the solver are copied, the rows are shared by
+	the two solvers until one of them modifies a row, which it first
+	replaces with a private copy. The copy draws its memory from the
+	resource of the original, which must outlive both. The variables are
+	shared too, so updating the variables of either solver writes them.
+	The copy does not pull the values of the variables and has no open
+	transaction. It runs its batch operations on the same executor.
 
-	SolverImpl( const SolverImpl& ) = delete;
+	*/
+	SolverImpl( const SolverImpl& other ) :
+		m_pool( other.resource() ),
+		m_cns( other.m_cns ),
+		m_rows( other.m_rows ),
+		m_columns( other.m_columns ),
+		m_column_scratch( other.resource() ),
+		m_components( other.m_components ),
+		m_vars( other.m_vars ),
+		m_symbol_vars( other.m_symbol_vars ),
+		m_edits( other.m_edits ),
+		m_infeasible_rows( other.m_infeasible_rows ),
+		m_objective( m_pool.own( m_pool.acquire( *other.m_objective ) ) ),
+		m_artificial( nullptr, typename RowPool::Releaser( &m_pool ) ),
+		m_free_ids( other.m_free_ids ),
+		m_changed( other.m_changed ),
+		m_changed_flags( other.m_changed_flags ),
+		m_slot_symbols( other.m_slot_symbols ),
+		m_slot_values( other.m_slot_values ),
+		m_free_slots( other.m_free_slots ),
+		m_transactions( other.resource() ),
+		m_row_levels( other.resource() ),
+		m_batch_released( other.resource() ),
+		m_executor( other.m_executor ),
+		m_id_tick( other.m_id_tick ),
+		m_basis_version( other.m_basis_version + 1 ),
+		m_epoch( 0 ),
+		m_defer_suggestions( other.m_defer_suggestions ),
+		m_pull_values( false ),
+		m_batch( false )
+	{
+		for( auto& rowPair : m_rows )
+			rowPair.second->retain();
+		for( auto& editPair : m_edits )
+			editPair.second.level = 0;
+		// The responses cached by the original hold the rows it now shares.
+		++other.m_basis_version;
+	}
 
 	SolverImpl( SolverImpl&& ) = delete;
 
-	~SolverImpl() { clearRows(); }
+	~SolverImpl()
+	{
+		while( !m_transactions.empty() )
+			commit();
+		if( m_pull_values )
+			detachVariables();
+		clearRows();
+	}
 
 	/* Add a constraint to the solver.
 
@@ -82,85 +352,1855 @@ public:
 	*/
 	void addConstraint( const Constraint& constraint )
 	{
-		if( m_cns.find( constraint ) != m_cns.end() )
-			throw DuplicateConstraint( constraint );
+		flushSuggestions();
+		insertConstraint( constraint );
 
-		// Creating a row causes symbols to be reserved for the variables
-		// in the constraint. If this method exits with an exception,
-		// then its possible those variables will linger in the var map.
-		// Since its likely that those variables will be used in other
-		// constraints and since exceptional conditions are uncommon,
-		// i'm not too worried about aggressive cleanup of the var map.
-		Tag tag;
-		std::unique_ptr<Row> rowptr( createRow( constraint, tag ) );
-		Symbol subject( chooseSubject( *rowptr, tag ) );
+		// Optimizing after each constraint is added performs less
+		// aggregate work due to a smaller average system size. It
+		// also ensures the solver remains in a consistent state.
+		optimize( *m_objective );
+	}
+
+	/* Add a range of constraints to the solver.
+
+	The rows of all the constraints are inserted in the tableau before
+	the objective is optimized once, instead of once per constraint.
+	Inserting a row keeps the tableau feasible, so a single optimization
+	pass reaches an optimum of the whole system.
+
+	If a constraint cannot be added, the constraints before it remain in
+	the solver, which is optimized before the exception is propagated.
+	The exception holds the offending constraint.
+
+	With an executor, the constraints are grouped by the independent parts
+	of the system they touch and the parts are solved concurrently. The
+	batch then draws fresh symbol ids, see BatchGuard, and the result is
+	the one of the batch added serially with fresh ids. If a constraint
+	cannot be added, the parts are dropped and the batch is added serially
+	to report it.
+
+	Throws
+	------
+	DuplicateConstraint
+		A given constraint has already been added to the solver.
+
+	UnsatisfiableConstraint
+		A given constraint is required and cannot be satisfied.
+
+	*/
+	template <typename InputIt>
+	void addConstraints( InputIt first, InputIt last )
+	{
+		flushSuggestions();
+		if( !m_executor || !m_transactions.empty() )
+		{
+			insertConstraints( first, last );
+			return;
+		}
+		CnList constraints( first, last, resource() );
+		if( !addConstraintsInParts( constraints ) )
+		{
+			BatchGuard guard( *this );
+			insertConstraints( constraints.begin(), constraints.end() );
+		}
+		trimFreeIds();
+	}
+
+	/* Remove a constraint from the solver.
+
+	Throws
+	------
+	UnknownConstraint
+		The given constraint has not been added to the solver.
+
+	*/
+	void removeConstraint( const Constraint& constraint )
+	{
+		flushSuggestions();
+		auto cn_it = m_cns.find( constraint );
+		if( cn_it == m_cns.end() )
+			throw UnknownConstraint( constraint );
+
+		Tag tag( cn_it->second );
+		m_cns.erase( cn_it );
+		logConstraint( constraint, tag, true );
+
+		// Remove the error effects from the objective function
+		// *before* pivoting, or substitutions into the objective
+		// will lead to incorrect solver results.
+		removeConstraintEffects( constraint, tag );
+
+		removeMarkerRow( tag );
+
+		// The symbols of the constraint can be reused once they are gone
+		// from the tableau. The other error symbol may remain as a plain
+		// restricted variable, in which case it is kept alive.
+		releaseSymbol( tag.marker );
+		releaseSymbol( tag.other );
+
+		// Optimizing after each constraint is removed ensures that the
+		// solver remains consistent. It makes the solver api easier to
+		// use at a small tradeoff for speed.
+		optimize( *m_objective );
+	}
+
+	/* Remove a range of constraints from the solver.
+
+	The constraints are first taken out of the constraint map, so that
+	an unknown constraint leaves the solver untouched. The effects of
+	all the constraints are then removed from the objective function,
+	their rows are dropped from the tableau in a single sweep and the
+	objective is optimized once.
+
+	Throws
+	------
+	UnknownConstraint
+		A given constraint has not been added to the solver, or is
+		given twice.
+
+	*/
+	template <typename InputIt>
+	void removeConstraints( InputIt first, InputIt last )
+	{
+		flushSuggestions();
+		TagList removed( resource() );
+		for( ; first != last; ++first )
+		{
+			auto cn_it = m_cns.find( *first );
+			if( cn_it == m_cns.end() )
+			{
+				for( const auto& cnPair : removed )
+					m_cns[ cnPair.first ] = cnPair.second;
+				throw UnknownConstraint( *first );
+			}
+			removed.push_back( std::make_pair( cn_it->first, cn_it->second ) );
+			m_cns.erase( cn_it );
+		}
+		for( const auto& cnPair : removed )
+			logConstraint( cnPair.first, cnPair.second, true );
+
+		// As for a single constraint, the error effects must be removed
+		// from the objective function *before* pivoting.
+		for( const auto& cnPair : removed )
+			removeConstraintEffects( cnPair.first, cnPair.second );
+		for( const auto& cnPair : removed )
+			removeMarkerRow( cnPair.second );
+		for( const auto& cnPair : removed )
+		{
+			releaseSymbol( cnPair.second.marker );
+			releaseSymbol( cnPair.second.other );
+		}
+
+		optimize( *m_objective );
+	}
+
+	/* Test whether a constraint has been added to the solver.
+
+	*/
+	bool hasConstraint( const Constraint& constraint ) const
+	{
+		return m_cns.find( constraint ) != m_cns.end();
+	}
+
+	/* Add an edit variable to the solver.
+
+	This method should be called before the `suggestValue` method is
+	used to supply a suggested value for the given edit variable.
+
+	Throws
+	------
+	DuplicateEditVariable
+		The given edit variable has already been added to the solver.
+
+	BadRequiredStrength
+		The given strength is >= required.
+
+	*/
+	void addEditVariable( const Variable& variable, double strength )
+	{
+		if( m_edits.find( variable ) != m_edits.end() )
+			throw DuplicateEditVariable( variable );
+		strength = strength::clip( strength );
+		if( strength == strength::required )
+			throw BadRequiredStrength();
+		Constraint cn( Expression( variable ), OP_EQ, strength );
+		addConstraint( cn );
+		EditInfo info( resource() );
+		info.tag = m_cns[ cn ];
+		info.constraint = cn;
+		info.constant = 0.0;
+		info.level = m_transactions.size();
+		m_edits.insert( typename EditMap::value_type( variable, info ) );
+		logEdit( EditChange::Added, variable, info );
+	}
+
+	/* Remove an edit variable from the solver.
+
+	Throws
+	------
+	UnknownEditVariable
+		The given edit variable has not been added to the solver.
+
+	*/
+	void removeEditVariable( const Variable& variable )
+	{
+		auto it = m_edits.find( variable );
+		if( it == m_edits.end() )
+			throw UnknownEditVariable( variable );
+		removeConstraint( it->second.constraint );
+		logEdit( EditChange::Removed, variable, it->second );
+		m_edits.erase( it );
+	}
+
+	/* Test whether an edit variable has been added to the solver.
+
+	*/
+	bool hasEditVariable( const Variable& variable ) const
+	{
+		return m_edits.find( variable ) != m_edits.end();
+	}
+
+	/* Suggest a value for the given edit variable.
+
+	This method should be used after an edit variable as been added to
+	the solver in order to suggest the value for that variable.
+
+	Throws
+	------
+	UnknownEditVariable
+		The given edit variable has not been added to the solver.
+
+	*/
+	void suggestValue( const Variable& variable, double value )
+	{
+		if( m_defer_suggestions )
+		{
+			applySuggestion( variable, value );
+			return;
+		}
+		DualOptimizeGuard guard( *this );
+		applySuggestion( variable, value );
+	}
+
+	/* Suggest values for a range of edit variables.
+
+	The range holds pairs of an edit variable and its suggested value.
+	All the suggestions are applied before the system is dual optimized
+	once, instead of once per suggestion.
+
+	Throws
+	------
+	UnknownEditVariable
+		A given edit variable has not been added to the solver. The
+		suggestions which precede it are kept.
+
+	*/
+	template <typename InputIt>
+	void suggestValues( InputIt first, InputIt last )
+	{
+		if( m_defer_suggestions )
+		{
+			for( ; first != last; ++first )
+				applySuggestion( first->first, first->second );
+			return;
+		}
+		DualOptimizeGuard guard( *this );
+		for( ; first != last; ++first )
+			applySuggestion( first->first, first->second );
+	}
+
+	/* Set whether the dual optimization of suggestions is deferred.
+
+	In the deferred mode, suggesting a value only updates the rows of the
+	tableau and records the rows it makes infeasible. A single dual
+	optimization then runs before the variables are updated or the
+	constraints or edit variables of the solver are modified. Leaving the
+	deferred mode runs the pending optimization.
+
+	*/
+	void setDeferSuggestions( bool defer )
+	{
+		m_defer_suggestions = defer;
+		if( !defer )
+			dualOptimize();
+	}
+
+	/* Test whether the dual optimization of suggestions is deferred.
+
+	*/
+	bool deferSuggestions() const
+	{
+		return m_defer_suggestions;
+	}
+
+	/* Set the executor running the independent parts of batch operations.
+
+	The constraints added by addConstraints and the dual optimization of
+	the suggested values are split over the independent parts of the
+	system, which the executor solves concurrently. The parts are merged
+	back in a fixed order before the call returns. The dual optimization
+	reaches the same tableau as without an executor. A batch of constraints
+	draws fresh symbol ids, see BatchGuard, and matches the batch added
+	serially with the same fresh ids. Once constraints were removed, the
+	serial solver reuses their ids instead, which may pivot differently
+	and pick another of several optimal solutions. A null executor, the
+	default, runs everything on the calling thread. The executor must
+	outlive its use by the solver.
+
+	*/
+	void setExecutor( Executor* executor )
+	{
+		m_executor = executor;
+	}
+
+	/* Get the executor of the batch operations, null if there is none.
+
+	*/
+	Executor* executor() const
+	{
+		return m_executor;
+	}
+
+	/* Compute the derivatives of the external variables with respect to
+	the value suggested for an edit variable.
+
+	The derivatives are the factors of the rows which move with the edit
+	variable, so they are read from the tableau without solving. They are
+	valid until a suggestion or a modification of the solver changes its
+	basis. The variables which do not move are not listed.
+
+	*/
+	void sensitivity( const Variable& variable, std::vector<std::pair<Variable, double>>& derivatives )
+	{
+		flushSuggestions();
+		auto it = m_edits.find( variable );
+		if( it == m_edits.end() )
+			throw UnknownEditVariable( variable );
+		EditInfo& info = it->second;
+		if( info.version != m_basis_version )
+			cacheResponse( info );
+		derivatives.clear();
+		for( const Response& response : info.response )
+		{
+			if( response.basic.type() != Symbol::External )
+				continue;
+			auto var_it = m_symbol_vars.find( response.basic );
+			if( var_it != m_symbol_vars.end() )
+				derivatives.push_back( std::make_pair( var_it->second, double( response.factor ) ) );
+		}
+	}
+
+	/* Solve the system over a range of values of an edit variable.
+
+	The solver is first solved for the low end of the range. The value of
+	the edit variable then moves up to the next value at which a row of
+	the response of the edit variable would become infeasible, where the
+	row leaves the basis with a dual pivot, until the high end is reached.
+	Each step is a segment of the sweep. The solver is then solved again
+	for the value suggested before the sweep.
+
+	Rows blocking at the same value leave the basis lowest symbol first,
+	as in Bland's rule, and a run of degenerate pivots at one value is
+	bounded by the number of rows. A sweep which would pivot more than
+	that throws an InternalSolverError rather than cycle.
+
+	*/
+	Sweep sweep( const Variable& variable, double lo, double hi )
+	{
+		flushSuggestions();
+		auto it = m_edits.find( variable );
+		if( it == m_edits.end() )
+			throw UnknownEditVariable( variable );
+		if( hi < lo )
+			std::swap( lo, hi );
+		EditInfo& info = it->second;
+		double initial = info.constant;
+
+		Sweep sweep;
+		std::vector<Symbol> symbols;
+		std::vector<std::size_t> indices( m_id_tick, 0 );
+		symbols.reserve( m_vars.size() );
+		sweep.m_variables.reserve( m_vars.size() );
+		for( const auto& varPair : m_vars )
+		{
+			indices[ varPair.second.id() ] = symbols.size();
+			symbols.push_back( varPair.second );
+			sweep.m_variables.push_back( varPair.first );
+		}
+		const std::size_t count = sweep.m_variables.size();
+
+		applySuggestion( variable, lo );
+		dualOptimize();
+		double value = lo;
+		sweep.m_breakpoints.push_back( lo );
+		std::size_t degenerate = 0;
+		while( true )
+		{
+			if( info.version != m_basis_version )
+				cacheResponse( info );
+
+			// Find the first row which would become infeasible.
+			double step = hi - value;
+			auto blocking = m_rows.end();
+			for( const Response& response : info.response )
+			{
+				if( response.basic.type() == Symbol::External ||
+					!( response.factor < T( 0 ) ) )
+					continue;
+				double constant = std::max( 0.0, double( response.row->constant() ) );
+				double distance = constant / -double( response.factor );
+				if( distance < step || ( distance == step &&
+					blocking != m_rows.end() && response.basic < blocking->first ) )
+				{
+					step = distance;
+					blocking = m_rows.find( response.basic );
+				}
+			}
+
+			// Record the segment, degenerate steps only change the basis.
+			if( step > 0.0 || blocking == m_rows.end() )
+			{
+				std::size_t offset = sweep.m_offsets.size();
+				sweep.m_offsets.resize( offset + count );
+				sweep.m_slopes.resize( offset + count, 0.0 );
+				for( std::size_t i = 0; i < count; ++i )
+					sweep.m_offsets[ offset + i ] = symbolValue( symbols[ i ] );
+				for( const Response& response : info.response )
+				{
+					if( response.basic.type() == Symbol::External )
+						sweep.m_slopes[ offset + indices[ response.basic.id() ] ] = double( response.factor );
+				}
+				value = blocking == m_rows.end() ? hi : value + step;
+				sweep.m_breakpoints.push_back( value );
+				degenerate = 0;
+			}
+			if( blocking == m_rows.end() )
+				break;
+			if( step <= 0.0 && ++degenerate > m_rows.size() )
+			{
+				applySuggestion( variable, initial );
+				dualOptimize();
+				throw InternalSolverError( "The sweep did not terminate." );
+			}
+
+			applySuggestion( variable, value );
+			dualPivot( blocking );
+			dualOptimize();
+		}
+
+		applySuggestion( variable, initial );
+		dualOptimize();
+		return sweep;
+	}
+
+	/* Count the independent parts of the system.
+
+	Two variables are in the same part when the tableau links them, so
+	changing the constraints or the suggested values of one part leaves
+	the values of the other parts untouched. A variable without any
+	constraint is a part of its own.
+
+	*/
+	std::size_t componentCount()
+	{
+		refreshComponents();
+		IdList roots( resource() );
+		for( const auto& varPair : m_vars )
+			roots.push_back( m_components.find( varPair.second.id() ) );
+		std::sort( roots.begin(), roots.end() );
+		return std::size_t( std::unique( roots.begin(), roots.end() ) - roots.begin() );
+	}
+
+	/* Test whether two variables are in the same part of the system.
+
+	A variable which is not in the solver is in no part.
+
+	*/
+	bool connected( const Variable& first, const Variable& second )
+	{
+		auto first_it = m_vars.find( first );
+		auto second_it = m_vars.find( second );
+		if( first_it == m_vars.end() || second_it == m_vars.end() )
+			return false;
+		refreshComponents();
+		return m_components.find( first_it->second.id() ) == m_components.find( second_it->second.id() );
+	}
+
+	/* Update the values of the external solver variables.
+
+	*/
+	void updateVariables()
+	{
+		flushSuggestions();
+		refreshValueSlots();
+		if( m_pull_values )
+		{
+			++m_epoch;
+			clearChanged();
+			return;
+		}
+		auto row_end = m_rows.end();
+
+		for (auto &varPair : m_vars)
+		{
+			Variable var( varPair.first );
+			auto row_it = m_rows.find( varPair.second );
+			if( row_it == row_end )
+				var.setValue( 0.0 );
+			else
+				var.setValue( double( row_it->second->constant() ) );
+		}
+		clearChanged();
+	}
+
+	/* Update the values of the variables changed since the last update.
+
+	The solver records the variables whose row was modified, entered or
+	left the basis, so only those are looked up. A variable is written
+	and appended to the output only if its value moved by more than the
+	given epsilon, otherwise it keeps its last written value.
+
+	*/
+	void updateChangedVariables( std::vector<Variable>& changed, double epsilon = 0.0 )
+	{
+		flushSuggestions();
+		refreshValueSlots();
+		if( m_pull_values )
+			++m_epoch;
+		changed.clear();
+		auto row_end = m_rows.end();
+		for( const Symbol& sym : m_changed )
+		{
+			m_changed_flags[ sym.id() ] = 0;
+			auto var_it = m_symbol_vars.find( sym );
+			if( var_it == m_symbol_vars.end() )
+				continue;
+			auto row_it = m_rows.find( sym );
+			double value = row_it == row_end ? 0.0 : double( row_it->second->constant() );
+			Variable& var = var_it->second;
+			double last = var.cachedValue();
+			if( std::fabs( value - last ) > epsilon )
+			{
+				var.setValue( value );
+				changed.push_back( var );
+			}
+			else if( m_pull_values )
+				var.setValue( last );
+		}
+		m_changed.clear();
+	}
+
+	/* Write the current values of a range of variables to a buffer.
+
+	The values are read from the tableau, independently of the values
+	held by the variables. A variable unknown to the solver is zero.
+
+	*/
+	template <typename InputIt>
+	void exportValues( InputIt first, InputIt last, double* out )
+	{
+		flushSuggestions();
+		auto var_end = m_vars.end();
+		for( ; first != last; ++first, ++out )
+		{
+			auto var_it = m_vars.find( *first );
+			*out = var_it == var_end ? 0.0 : symbolValue( var_it->second );
+		}
+	}
+
+	/* Give a variable a slot in the value array of the solver.
+
+	The value array is refreshed by each update of the variables, which
+	lets a reader consume many values as one contiguous array. The slot
+	of a variable is stable until it is removed, the slots of removed
+	variables are reused. The variable is added to the solver if needed.
+
+	*/
+	std::size_t addValueSlot( const Variable& variable )
+	{
+		Symbol symbol( getVarSymbol( variable ) );
+		std::size_t slot;
+		if( m_free_slots.empty() )
+		{
+			slot = m_slot_symbols.size();
+			m_slot_symbols.push_back( symbol );
+			m_slot_values.push_back( 0.0 );
+		}
+		else
+		{
+			slot = m_free_slots.back();
+			m_free_slots.pop_back();
+			m_slot_symbols[ slot ] = symbol;
+		}
+		m_slot_values[ slot ] = symbolValue( symbol );
+		return slot;
+	}
+
+	/* Free a slot of the value array, which then holds zero.
+
+	*/
+	void removeValueSlot( std::size_t slot )
+	{
+		if( slot >= m_slot_symbols.size() ||
+			m_slot_symbols[ slot ].type() == Symbol::Invalid )
+			return;
+		m_slot_symbols[ slot ] = Symbol();
+		m_slot_values[ slot ] = 0.0;
+		m_free_slots.push_back( slot );
+	}
+
+	/* Get the value array, which holds a value per slot.
+
+	*/
+	const double* valueSlots() const
+	{
+		return m_slot_values.data();
+	}
+
+	/* Get the number of slots of the value array, including free ones.
+
+	*/
+	std::size_t valueSlotCount() const
+	{
+		return m_slot_values.size();
+	}
+
+	/* Set whether the variables pull their values from the solver.
+
+	In the pull mode, the variables of the solver are attached to it and
+	resolve their value from the tableau when it is first read after an
+	update, so updating the variables takes a constant time. The last
+	solver to attach a variable provides its value. Leaving the pull
+	mode, resetting or destroying the solver detaches the variables,
+	which keep the values of the current solution.
+
+	*/
+	void setPullValues( bool pull )
+	{
+		if( pull == m_pull_values )
+			return;
+		if( pull )
+		{
+			for( const auto& varPair : m_vars )
+				Variable( varPair.first ).setResolver( this, varPair.second.id() );
+			++m_epoch;
+		}
+		else
+			detachVariables();
+		m_pull_values = pull;
+	}
+
+	/* Test whether the variables pull their values from the solver.
+
+	*/
+	bool pullValues() const
+	{
+		return m_pull_values;
+	}
+
+	/* Reset the solver to the empty starting condition.
+
+	This method resets the internal solver state to the empty starting
+	condition, as if no constraints or edit variables have been added.
+	This can be faster than deleting the solver and creating a new one
+	when the entire system must change, since it can avoid unecessary
+	heap (de)allocations: the rows are returned to the row pool and
+	keep the capacity of their cell arrays for the next system. The open
+	transactions are committed.
+
+	*/
+	void reset()
+	{
+		while( !m_transactions.empty() )
+			commit();
+		if( m_pull_values )
+			detachVariables();
+		clearRows();
+		m_components.clear();
+		m_cns.clear();
+		m_vars.clear();
+		m_symbol_vars.clear();
+		m_edits.clear();
+		m_infeasible_rows.clear();
+		m_objective->clear();
+		m_artificial.reset();
+		m_free_ids.clear();
+		clearChanged();
+		m_slot_symbols.clear();
+		m_slot_values.clear();
+		m_free_slots.clear();
+		m_id_tick = 1;
+	}
+
+	/* Renumber the live symbols into the dense range [1, n].
+
+	Removing constraints returns the ids of their symbols to a free list,
+	but ids can still be lost, for instance when a constraint is rejected
+	as unsatisfiable. This method gives the n live symbols the ids 1 to n
+	and empties the free list. The renumbering preserves the order of the
+	symbols, so the solver makes the same pivoting choices afterwards.
+	The logs of the transactions hold the old ids, so nothing is done
+	while a transaction is open.
+
+	*/
+	void compact()
+	{
+		if( !m_transactions.empty() )
+			return;
+		flushSuggestions();
+		IdList live( resource() );
+		for( const auto& varPair : m_vars )
+			live.push_back( varPair.second.id() );
+		for( const auto& cnPair : m_cns )
+		{
+			live.push_back( cnPair.second.marker.id() );
+			live.push_back( cnPair.second.other.id() );
+		}
+		for( const auto& rowPair : m_rows )
+		{
+			live.push_back( rowPair.first.id() );
+			for( const Symbol& sym : rowPair.second->symbols() )
+				live.push_back( sym.id() );
+		}
+		for( const Symbol& sym : m_objective->symbols() )
+			live.push_back( sym.id() );
+		std::sort( live.begin(), live.end() );
+		live.erase( std::unique( live.begin(), live.end() ), live.end() );
+		// The invalid symbols of the tags have the id 0, which keeps it.
+		if( !live.empty() && live.front() == 0 )
+			live.erase( live.begin() );
+
+		auto renumber = [ &live ]( const Symbol& sym ) -> Symbol
+		{
+			if( sym.type() == Symbol::Invalid )
+				return sym;
+			auto it = std::lower_bound( live.begin(), live.end(), sym.id() );
+			return Symbol( sym.type(), Symbol::Id( it - live.begin() ) + 1 );
+		};
+
+		for( auto& varPair : m_vars )
+			varPair.second = renumber( varPair.second );
+		m_symbol_vars.clear();
+		for( const auto& varPair : m_vars )
+		{
+			m_symbol_vars.insert( typename SymbolVarMap::value_type( varPair.second, varPair.first ) );
+			// Rekey the attached variables, their values are unchanged.
+			Variable var( varPair.first );
+			if( m_pull_values && var.resolver() == this )
+			{
+				double value = var.value();
+				var.setResolver( this, varPair.second.id() );
+				var.setValue( value );
+			}
+		}
+		for( auto& cnPair : m_cns )
+		{
+			cnPair.second.marker = renumber( cnPair.second.marker );
+			cnPair.second.other = renumber( cnPair.second.other );
+		}
+		for( auto& editPair : m_edits )
+		{
+			Tag& tag = editPair.second.tag;
+			tag.marker = renumber( tag.marker );
+			tag.other = renumber( tag.other );
+		}
+
+		// Rebuild the basis map in its iteration order and the column
+		// index from the renumbered rows.
+		RowMap rows( resource() );
+		for( auto& rowPair : m_rows )
+		{
+			ownRow( rowPair.first, rowPair.second )->renumber( renumber );
+			rows.insert( typename RowMap::value_type( renumber( rowPair.first ), rowPair.second ) );
+		}
+		m_rows = std::move( rows );
+		m_columns.clear();
+		for( const auto& rowPair : m_rows )
+		{
+			for( const Symbol& sym : rowPair.second->symbols() )
+				m_columns.add( sym, rowPair.first );
+		}
+		m_objective->renumber( renumber );
+		m_components.setStale();
+
+		auto infeasible = m_infeasible_rows.begin();
+		for( const Symbol& sym : m_infeasible_rows )
+		{
+			if( std::binary_search( live.begin(), live.end(), sym.id() ) )
+				*infeasible++ = renumber( sym );
+		}
+		m_infeasible_rows.erase( infeasible, m_infeasible_rows.end() );
+
+		for( Symbol& sym : m_slot_symbols )
+			sym = renumber( sym );
+
+		// The changed symbols are all external, hence live.
+		std::fill( m_changed_flags.begin(), m_changed_flags.end(), 0 );
+		for( Symbol& sym : m_changed )
+		{
+			sym = renumber( sym );
+			m_changed_flags[ sym.id() ] = 1;
+		}
+
+		m_free_ids.clear();
+		m_id_tick = Symbol::Id( live.size() ) + 1;
+		++m_basis_version;
+	}
+
+	/* Begin a transaction, nested in the open ones.
+
+	The rows are logged the first time they change in the transaction,
+	the changes of the constraints, edit variables and suggestions are
+	logged as they happen and the small state of the solver is saved.
+
+	*/
+	void beginTransaction()
+	{
+		flushSuggestions();
+		m_transactions.emplace_back( resource() );
+		Transaction& transaction = m_transactions.back();
+		transaction.free_ids = m_free_ids;
+		transaction.slot_symbols = m_slot_symbols;
+		transaction.free_slots = m_free_slots;
+		transaction.objective = m_pool.acquire( *m_objective );
+		transaction.id_tick = m_id_tick;
+		// The cached responses must log the rows they change.
+		++m_basis_version;
+	}
+
+	/* Keep the changes of the innermost transaction.
+
+	The changes logged for the first time in the transaction are handed
+	to the enclosing one, the others are dropped.
+
+	*/
+	void commit()
+	{
+		if( m_transactions.empty() )
+			return;
+		std::size_t level = m_transactions.size();
+		Transaction& transaction = m_transactions.back();
+		if( level == 1 )
+		{
+			for( const RowChange& change : transaction.rows )
+			{
+				if( change.row )
+					releaseRow( change.row );
+				m_row_levels[ change.basic.id() ] = 0;
+			}
+			for( const EditChange& change : transaction.edits )
+			{
+				auto it = m_edits.find( change.variable );
+				if( it != m_edits.end() )
+					it->second.level = 0;
+			}
+			m_free_ids.insert( m_free_ids.end(), transaction.released.begin(), transaction.released.end() );
+		}
+		else
+		{
+			Transaction& outer = m_transactions[ level - 2 ];
+			for( const RowChange& change : transaction.rows )
+			{
+				if( change.level == level - 1 )
+				{
+					if( change.row )
+						releaseRow( change.row );
+				}
+				else
+					outer.rows.push_back( change );
+				m_row_levels[ change.basic.id() ] = level - 1;
+			}
+			for( const EditChange& change : transaction.edits )
+			{
+				if( change.kind != EditChange::Suggested || change.level != level - 1 )
+					outer.edits.push_back( change );
+				auto it = m_edits.find( change.variable );
+				if( it != m_edits.end() && it->second.level == level )
+					it->second.level = level - 1;
+			}
+			outer.constraints.insert( outer.constraints.end(),
+				transaction.constraints.begin(), transaction.constraints.end() );
+			outer.variables.insert( outer.variables.end(),
+				transaction.variables.begin(), transaction.variables.end() );
+			outer.released.insert( outer.released.end(),
+				transaction.released.begin(), transaction.released.end() );
+		}
+		m_pool.release( transaction.objective );
+		m_transactions.pop_back();
+		++m_basis_version;
+	}
+
+	/* Undo the changes of the innermost transaction.
+
+	The logged rows are put back in the tableau and the logs of the
+	constraints and edit variables are undone in reverse order.
+
+	*/
+	void rollback()
+	{
+		if( m_transactions.empty() )
+			return;
+		Transaction& transaction = m_transactions.back();
+		m_components.setStale();
+		for( const RowChange& change : transaction.rows )
+		{
+			auto row_it = m_rows.find( change.basic );
+			if( row_it != m_rows.end() )
+			{
+				Row* row = row_it->second;
+				for( const Symbol& sym : row->symbols() )
+					m_columns.remove( sym, change.basic );
+				m_rows.erase( row_it );
+				releaseRow( row );
+			}
+			if( change.row )
+			{
+				m_rows[ change.basic ] = change.row;
+				for( const Symbol& sym : change.row->symbols() )
+					m_columns.add( sym, change.basic );
+			}
+			m_row_levels[ change.basic.id() ] = change.level;
+			markChanged( change.basic );
+		}
+
+		for( auto it = transaction.constraints.rbegin(); it != transaction.constraints.rend(); ++it )
+		{
+			if( it->removed )
+				m_cns[ it->constraint ] = it->tag;
+			else
+				m_cns.erase( m_cns.find( it->constraint ) );
+		}
+
+		for( auto it = transaction.edits.rbegin(); it != transaction.edits.rend(); ++it )
+		{
+			if( it->kind == EditChange::Added )
+				m_edits.erase( m_edits.find( it->variable ) );
+			else if( it->kind == EditChange::Removed )
+			{
+				EditInfo info( resource() );
+				info.tag = it->tag;
+				info.constraint = it->constraint;
+				info.constant = it->constant;
+				info.level = it->level;
+				m_edits.insert( typename EditMap::value_type( it->variable, info ) );
+			}
+			else
+			{
+				EditInfo& info = m_edits.find( it->variable )->second;
+				info.constant = it->constant;
+				info.level = it->level;
+			}
+		}
+
+		for( const Variable& variable : transaction.variables )
+		{
+			auto var_it = m_vars.find( variable );
+			Variable var( variable );
+			if( m_pull_values && var.resolver() == this )
+			{
+				var.setValue( var.value() );
+				var.setResolver( nullptr );
+			}
+			m_symbol_vars.erase( m_symbol_vars.find( var_it->second ) );
+			m_vars.erase( var_it );
+		}
+
+		m_free_ids.swap( transaction.free_ids );
+		m_id_tick = transaction.id_tick;
+		*m_objective = *transaction.objective;
+		m_pool.release( transaction.objective );
+		m_slot_symbols.swap( transaction.slot_symbols );
+		m_free_slots.swap( transaction.free_slots );
+		m_slot_values.resize( m_slot_symbols.size() );
+		refreshValueSlots();
+		m_infeasible_rows.clear();
+		m_transactions.pop_back();
+		++m_basis_version;
+		if( m_pull_values )
+			++m_epoch;
+	}
+
+	/* Get the number of open transactions.
+
+	*/
+	std::size_t transactionDepth() const
+	{
+		return m_transactions.size();
+	}
+
+	/* Write the state of the solver to a snapshot, see SnapshotHeader.
+
+	The variables and the constraints are written as the integer keys
+	returned by the key functions. The edit constraints are created by
+	the solver and are written with their edit variable instead.
+
+	*/
+	template <typename VarKey, typename CnKey>
+	void save( std::vector<char>& buffer, VarKey varKey, CnKey cnKey )
+	{
+		flushSuggestions();
+		SnapshotHeader header( SnapshotHeader::create( sizeof( T ) ) );
+		header.idTick = m_id_tick;
+		header.freeIds = m_free_ids.size();
+		header.variables = m_vars.size();
+		header.constraints = m_cns.size() - m_edits.size();
+		header.edits = m_edits.size();
+		header.rows = m_rows.size();
+
+		SnapshotWriter writer( buffer );
+		writer.write( header );
+		for( Symbol::Id id : m_free_ids )
+			writer.write( std::uint64_t( id ) );
+		for( const auto& varPair : m_vars )
+		{
+			writer.write( std::uint64_t( varKey( varPair.first ) ) );
+			writer.write( varPair.second );
+		}
+		for( const auto& cnPair : m_cns )
+		{
+			if( isEditConstraint( cnPair.first ) )
+				continue;
+			writer.write( std::uint64_t( cnKey( cnPair.first ) ) );
+			writer.write( cnPair.second.marker );
+			writer.write( cnPair.second.other );
+		}
+		for( const auto& editPair : m_edits )
+		{
+			writer.write( std::uint64_t( varKey( editPair.first ) ) );
+			writer.write( editPair.second.tag.marker );
+			writer.write( editPair.second.tag.other );
+			writer.write( editPair.second.constraint.strength() );
+			writer.write( editPair.second.constant );
+		}
+		writeRow( writer, Symbol(), *m_objective );
+		for( const auto& rowPair : m_rows )
+			writeRow( writer, rowPair.first, *rowPair.second );
+	}
+
+	/* Replace the state of the solver with a snapshot.
+
+	The variables and the constraints are the handles returned by the
+	handle functions for their keys. The rows are copied from the data,
+	which may be a mapped file, and the solver is then ready for new
+	suggestions without solving the system again. An invalid snapshot
+	leaves the solver empty.
+
+	Throws
+	------
+	BadSnapshot
+		The data is not a valid snapshot for this solver.
+
+	*/
+	template <typename VarFor, typename CnFor>
+	void load( const char* data, std::size_t size, VarFor variableFor, CnFor constraintFor )
+	{
+		reset();
+		try
+		{
+			readSnapshot( data, size, variableFor, constraintFor );
+			m_components.setStale();
+		}
+		catch( ... )
+		{
+			reset();
+			throw;
+		}
+	}
+
+	/* Get the memory resource used by the solver.
+
+	*/
+	MemoryResource* resource() const
+	{
+		return m_pool.resource();
+	}
+
+	SolverImpl& operator=( const SolverImpl& ) = delete;
+
+	SolverImpl& operator=( SolverImpl&& ) = delete;
+
+private:
+
+	/* Read a snapshot into the empty solver.
+
+	Every record is checked before it is used, so that a corrupt
+	snapshot is rejected rather than sizing the tables of the solver
+	from a bad id: the symbols must have a type expected by their record
+	and an id below the tick, the cells of a row must be sorted, each
+	variable, constraint, edit variable and basic symbol must be unique,
+	a basic symbol cannot appear in a row and a free id cannot be in use.
+
+	The tick is lowered past the largest id in use, as the ids above it
+	are only drawn later and new symbols then keep the same order.
+
+	*/
+	template <typename VarFor, typename CnFor>
+	void readSnapshot( const char* data, std::size_t size, VarFor& variableFor, CnFor& constraintFor )
+	{
+		SnapshotReader reader( data, size );
+		SnapshotHeader header( reader.read<SnapshotHeader>() );
+		header.check( sizeof( T ) );
+		const std::uint64_t tick = header.idTick;
+		if( tick == 0 )
+			throw BadSnapshot( "The snapshot has an invalid id tick." );
+
+		const char* ids = reader.take( header.freeIds, sizeof( std::uint64_t ) );
+		m_free_ids.resize( std::size_t( header.freeIds ) );
+		for( std::size_t i = 0; i < m_free_ids.size(); ++i )
+		{
+			std::uint64_t id;
+			std::memcpy( &id, ids + i * sizeof( id ), sizeof( id ) );
+			if( id == 0 || id >= tick )
+				throw BadSnapshot( "The snapshot has an invalid symbol." );
+			m_free_ids[ i ] = Symbol::Id( id );
+		}
+
+		for( std::uint64_t i = 0; i < header.variables; ++i )
+		{
+			Variable variable( variableFor( reader.read<std::uint64_t>() ) );
+			Symbol symbol( readSymbol( reader, tick, { Symbol::External } ) );
+			if( m_vars.find( variable ) != m_vars.end() ||
+				m_symbol_vars.find( symbol ) != m_symbol_vars.end() )
+				throw BadSnapshot( "The snapshot has a duplicate variable." );
+			m_vars[ variable ] = symbol;
+			m_symbol_vars.insert( typename SymbolVarMap::value_type( symbol, variable ) );
+		}
+
+		for( std::uint64_t i = 0; i < header.constraints; ++i )
+		{
+			Constraint constraint( constraintFor( reader.read<std::uint64_t>() ) );
+			Tag tag;
+			tag.marker = readSymbol( reader, tick, { Symbol::Slack, Symbol::Error, Symbol::Dummy } );
+			tag.other = readSymbol( reader, tick, { Symbol::Invalid, Symbol::Error } );
+			if( m_cns.find( constraint ) != m_cns.end() )
+				throw BadSnapshot( "The snapshot has a duplicate constraint." );
+			m_cns[ constraint ] = tag;
+		}
+
+		for( std::uint64_t i = 0; i < header.edits; ++i )
+		{
+			Variable variable( variableFor( reader.read<std::uint64_t>() ) );
+			EditInfo info( resource() );
+			info.tag.marker = readSymbol( reader, tick, { Symbol::Error } );
+			info.tag.other = readSymbol( reader, tick, { Symbol::Error } );
+			double strength = reader.read<double>();
+			info.constant = reader.read<double>();
+			if( !std::isfinite( strength ) || !std::isfinite( info.constant ) )
+				throw BadSnapshot( "The snapshot has a value which is not finite." );
+			if( m_edits.find( variable ) != m_edits.end() )
+				throw BadSnapshot( "The snapshot has a duplicate edit variable." );
+			info.constraint = Constraint( Expression( variable ), OP_EQ, strength );
+			m_cns[ info.constraint ] = info.tag;
+			m_edits.insert( typename EditMap::value_type( variable, info ) );
+		}
+
+		if( readRow( reader, tick, *m_objective ).type() != Symbol::Invalid )
+			throw BadSnapshot( "The snapshot has an invalid symbol." );
+		for( std::uint64_t i = 0; i < header.rows; ++i )
+		{
+			typename RowPool::Ptr rowptr( m_pool.own( m_pool.acquire() ) );
+			Symbol basic( readRow( reader, tick, *rowptr ) );
+			if( basic.type() == Symbol::Invalid )
+				throw BadSnapshot( "The snapshot has an invalid symbol." );
+			if( m_rows.find( basic ) != m_rows.end() )
+				throw BadSnapshot( "The snapshot has a duplicate row." );
+			insertRow( basic, rowptr.release() );
+		}
+
+		// The symbols in use, to check the rows and the free ids.
+		IdList live( resource() );
+		for( const auto& varPair : m_vars )
+			live.push_back( varPair.second.id() );
+		for( const auto& cnPair : m_cns )
+		{
+			live.push_back( cnPair.second.marker.id() );
+			live.push_back( cnPair.second.other.id() );
+		}
+		for( const Symbol& sym : m_objective->symbols() )
+		{
+			if( m_rows.find( sym ) != m_rows.end() )
+				throw BadSnapshot( "The snapshot has a basic symbol in a row." );
+			live.push_back( sym.id() );
+		}
+		for( const auto& rowPair : m_rows )
+		{
+			live.push_back( rowPair.first.id() );
+			for( const Symbol& sym : rowPair.second->symbols() )
+			{
+				if( m_rows.find( sym ) != m_rows.end() )
+					throw BadSnapshot( "The snapshot has a basic symbol in a row." );
+				live.push_back( sym.id() );
+			}
+		}
+		std::sort( live.begin(), live.end() );
+		live.erase( std::unique( live.begin(), live.end() ), live.end() );
+		IdList free( m_free_ids );
+		std::sort( free.begin(), free.end() );
+		for( std::size_t i = 0; i < free.size(); ++i )
+		{
+			if( ( i > 0 && free[ i ] == free[ i - 1 ] ) ||
+				std::binary_search( live.begin(), live.end(), free[ i ] ) )
+				throw BadSnapshot( "The snapshot has a free id in use." );
+		}
+		Symbol::Id last = 0;
+		if( !live.empty() )
+			last = live.back();
+		if( !free.empty() )
+			last = std::max( last, free.back() );
+		m_id_tick = last + 1;
+
+		for( const auto& varPair : m_vars )
+		{
+			markChanged( varPair.second );
+			if( m_pull_values )
+				Variable( varPair.first ).setResolver( this, varPair.second.id() );
+		}
+	}
+
+	/* Read a symbol of a snapshot.
+
+	Throws
+	------
+	BadSnapshot
+		The symbol is not of one of the given types or its id is not
+		below the tick. An invalid symbol must have the id 0.
+
+	*/
+	static Symbol readSymbol( SnapshotReader& reader, std::uint64_t tick, std::initializer_list<Symbol::Type> types )
+	{
+		Symbol symbol( reader.read<Symbol>() );
+		checkSymbol( symbol, tick, types );
+		return symbol;
+	}
+
+	static void checkSymbol( const Symbol& symbol, std::uint64_t tick, std::initializer_list<Symbol::Type> types )
+	{
+		if( std::find( types.begin(), types.end(), symbol.type() ) == types.end() )
+			throw BadSnapshot( "The snapshot has an invalid symbol." );
+		if( symbol.type() == Symbol::Invalid ? symbol.id() != 0 : symbol.id() == 0 || symbol.id() >= tick )
+			throw BadSnapshot( "The snapshot has an invalid symbol." );
+	}
+
+	static void writeRow( SnapshotWriter& writer, const Symbol& basic, const Row& row )
+	{
+		writer.write( basic );
+		writer.write( std::uint64_t( row.size() ) );
+		writer.write( row.constant() );
+		writer.align();
+		writer.writeBytes( row.symbols().data(), row.size() * sizeof( Symbol ) );
+		writer.writeBytes( row.coefficients().data(), row.size() * sizeof( T ) );
+		writer.align();
+	}
+
+	/* Read a row of a snapshot and return its basic symbol, which is
+	invalid for the objective.
+
+	*/
+	static Symbol readRow( SnapshotReader& reader, std::uint64_t tick, Row& row )
+	{
+		Symbol basic( readSymbol( reader, tick, { Symbol::Invalid, Symbol::External, Symbol::Slack, Symbol::Error, Symbol::Dummy } ) );
+		std::uint64_t size = reader.read<std::uint64_t>();
+		T constant = reader.read<T>();
+		reader.align();
+		const char* symbols = reader.take( size, sizeof( Symbol ) );
+		const char* coefficients = reader.take( size, sizeof( T ) );
+		reader.align();
+		row.assign( symbols, coefficients, std::size_t( size ), constant );
+		const typename Row::SymbolVector& syms( row.symbols() );
+		const typename Row::CoeffVector& coeffs( row.coefficients() );
+		if( !std::isfinite( constant ) )
+			throw BadSnapshot( "The snapshot has a value which is not finite." );
+		for( std::size_t i = 0; i < syms.size(); ++i )
+		{
+			checkSymbol( syms[ i ], tick, { Symbol::External, Symbol::Slack, Symbol::Error, Symbol::Dummy } );
+			if( i > 0 && !( syms[ i - 1 ] < syms[ i ] ) )
+				throw BadSnapshot( "The snapshot has an unsorted row." );
+			if( !std::isfinite( coeffs[ i ] ) )
+				throw BadSnapshot( "The snapshot has a value which is not finite." );
+		}
+		return basic;
+	}
+
+	/* Test whether a constraint is the constraint of an edit variable.
+
+	*/
+	bool isEditConstraint( const Constraint& constraint ) const
+	{
+		const auto& terms = constraint.expression().terms();
+		if( terms.size() != 1 )
+			return false;
+		auto it = m_edits.find( terms.front().variable() );
+		return it != m_edits.end() && it->second.constraint == constraint;
+	}
+
+	/* Apply a suggested value to the rows of the tableau.
+
+	The rows made infeasible by the suggestion are recorded for the next
+	dual optimization.
+
+	Throws
+	------
+	UnknownEditVariable
+		The given edit variable has not been added to the solver.
+
+	*/
+	void applySuggestion( const Variable& variable, double value )
+	{
+		auto it = m_edits.find( variable );
+		if( it == m_edits.end() )
+			throw UnknownEditVariable( variable );
+
+		EditInfo& info = it->second;
+		if( info.level != m_transactions.size() )
+		{
+			logEdit( EditChange::Suggested, variable, info );
+			info.level = m_transactions.size();
+		}
+		T delta = T( value - info.constant );
+		info.constant = value;
+
+		// While the basis is unchanged, the rows which move with the edit
+		// variable and their factors are cached, so an update only needs
+		// a multiply-add per row.
+		if( info.version != m_basis_version )
+			cacheResponse( info );
+		for( const Response& response : info.response )
+		{
+			markChanged( response.basic );
+			if( response.row->add( delta * response.factor ) < T( 0 ) &&
+				response.basic.type() != Symbol::External )
+				m_infeasible_rows.push_back( response.basic );
+		}
+	}
+
+	/* Compute the rows which move with an edit variable.
+
+	If the positive or the negative error variable of the edit constraint
+	is basic, only its row moves. Otherwise, each row which contains the
+	error variables moves by the coefficient of the positive one.
+
+	*/
+	void cacheResponse( EditInfo& info )
+	{
+		info.response.clear();
+
+		// Check first if the positive error variable is basic.
+		auto row_it = m_rows.find( info.tag.marker );
+		if( row_it != m_rows.end() )
+			info.response.push_back( Response{ row_it->first, ownRow( row_it->first, row_it->second ), T( -1 ) } );
+		else
+		{
+			// Check next if the negative error variable is basic.
+			row_it = m_rows.find( info.tag.other );
+			if( row_it != m_rows.end() )
+				info.response.push_back( Response{ row_it->first, ownRow( row_it->first, row_it->second ), T( 1 ) } );
+			else
+			{
+				// Otherwise use each row where the error variables exist.
+				for( const Symbol& basic : m_columns.rows( info.tag.marker ) )
+				{
+					Row* row = ownRow( basic, m_rows.find( basic )->second );
+					info.response.push_back( Response{ basic, row, row->coefficientFor( info.tag.marker ) } );
+				}
+			}
+		}
+
+		// Owning a shared row changes the basis version.
+		info.version = m_basis_version;
+	}
+
+
+	/* Get the current value of a symbol, zero unless it is basic.
+
+	*/
+	double symbolValue( const Symbol& symbol ) const
+	{
+		auto row_it = m_rows.find( symbol );
+		if( row_it == m_rows.end() )
+			return 0.0;
+		return double( row_it->second->constant() );
+	}
+
+	/* Copy the current values of the slotted variables to their slots.
+
+	*/
+	void refreshValueSlots()
+	{
+		for( std::size_t i = 0; i < m_slot_symbols.size(); ++i )
+		{
+			if( m_slot_symbols[ i ].type() != Symbol::Invalid )
+				m_slot_values[ i ] = symbolValue( m_slot_symbols[ i ] );
+		}
+	}
+
+	/* Resolve the value of the variable of the given external symbol id.
+
+	The suggestions deferred since the last update are optimized first,
+	so reading a variable can throw an InternalSolverError.
+
+	*/
+	double resolve( unsigned long long key ) override
+	{
+		flushSuggestions();
+		return symbolValue( Symbol( Symbol::External, key ) );
+	}
+
+	unsigned long long epoch() const override
+	{
+		return m_epoch;
+	}
+
+	/* Detach the attached variables, which keep their current value.
+
+	*/
+	void detachVariables()
+	{
+		for( const auto& varPair : m_vars )
+		{
+			Variable var( varPair.first );
+			if( var.resolver() == this )
+			{
+				var.setValue( var.value() );
+				var.setResolver( nullptr );
+			}
+		}
+	}
+
+	/* Run the dual optimization deferred by the pending suggestions.
+
+	*/
+	void flushSuggestions()
+	{
+		if( m_defer_suggestions )
+			dualOptimize();
+	}
+
+	/* Insert the row of a constraint in the tableau.
+
+	The objective function is not optimized, this is left to the caller.
+
+	*/
+	void insertConstraint( const Constraint& constraint )
+	{
+		if( m_cns.find( constraint ) != m_cns.end() )
+			throw DuplicateConstraint( constraint );
+
+		// Creating a row causes symbols to be reserved for the variables
+		// in the constraint. If this method exits with an exception,
+		// then its possible those variables will linger in the var map.
+		// Since its likely that those variables will be used in other
+		// constraints and since exceptional conditions are uncommon,
+		// i'm not too worried about aggressive cleanup of the var map.
+		Tag tag;
+		typename RowPool::Ptr rowptr( createRow( constraint, tag ) );
+		uniteComponents( *rowptr );
+		Symbol subject( chooseSubject( *rowptr, tag ) );
+
+		// If chooseSubject could not find a valid entering symbol, one
+		// last option is available if the entire row is composed of
+		// dummy variables. If the constant of the row is zero, then
+		// this represents redundant constraints and the new dummy
+		// marker can enter the basis. If the constant is non-zero,
+		// then it represents an unsatisfiable constraint.
+		if( subject.type() == Symbol::Invalid && allDummies( *rowptr ) )
+		{
+			if( !nearZero( rowptr->constant() ) )
+			{
+				m_components.setStale();
+				throw UnsatisfiableConstraint( constraint );
+			}
+			else
+				subject = tag.marker;
+		}
+
+		// If an entering symbol still isn't found, then the row must
+		// be added using an artificial variable. If that fails, then
+		// the row represents an unsatisfiable constraint.
+		if( subject.type() == Symbol::Invalid )
+		{
+			if( !addWithArtificialVariable( *rowptr ) )
+			{
+				m_components.setStale();
+				throw UnsatisfiableConstraint( constraint );
+			}
+		}
+		else
+		{
+			rowptr->solveFor( subject );
+			substitute( subject, *rowptr );
+			insertRow( subject, rowptr.release() );
+		}
+
+		m_cns[ constraint ] = tag;
+		logConstraint( constraint, tag, false );
+	}
+
+	/* Insert the rows of a batch of constraints and optimize once.
+
+	*/
+	template <typename InputIt>
+	void insertConstraints( InputIt first, InputIt last )
+	{
+		try
+		{
+			for( ; first != last; ++first )
+				insertConstraint( *first );
+		}
+		catch( ... )
+		{
+			optimize( *m_objective );
+			throw;
+		}
+		optimize( *m_objective );
+	}
+
+	/* Add a batch of constraints by solving its independent parts apart.
+
+	Two constraints are in the same part when they share a variable, or
+	variables of the same component of the tableau, and a part holds the
+	components its constraints touch. Returns false, leaving the solver
+	untouched, when the batch should be added serially: it has a known or
+	repeated constraint, a single part, or a constraint which cannot be
+	added.
+
+	*/
+	bool addConstraintsInParts( const CnList& constraints )
+	{
+		using VarIndexMap = typename Policy::template Map<Variable, std::size_t>;
+
+		CnMap seen( resource() );
+		for( const Constraint& constraint : constraints )
+		{
+			if( m_cns.find( constraint ) != m_cns.end() || seen.find( constraint ) != seen.end() )
+				return false;
+			seen[ constraint ] = Tag();
+		}
+
+		// Join each constraint with the first one using the same new
+		// variable or the same component, in a union-find over the
+		// indices of the constraints.
+		refreshComponents();
+		ComponentIndex groups;
+		RootMap rootFirst;
+		VarIndexMap varFirst( resource() );
+		for( std::size_t i = 0; i < constraints.size(); ++i )
+		{
+			for( const Term& term : constraints[ i ].expression().terms() )
+			{
+				std::size_t first = i;
+				auto var_it = m_vars.find( term.variable() );
+				if( var_it != m_vars.end() )
+					first = rootFirst.insert( std::make_pair( m_components.find( var_it->second.id() ), i ) ).first->second;
+				else
+				{
+					auto first_it = varFirst.find( term.variable() );
+					if( first_it == varFirst.end() )
+						varFirst[ term.variable() ] = i;
+					else
+						first = first_it->second;
+				}
+				groups.unite( Symbol::Id( first ), Symbol::Id( i ) );
+			}
+		}
+
+		RootMap groupPart;
+		std::vector<std::size_t> partOf( constraints.size() );
+		for( std::size_t i = 0; i < constraints.size(); ++i )
+			partOf[ i ] = groupPart.insert( std::make_pair( groups.find( Symbol::Id( i ) ), groupPart.size() ) ).first->second;
+		if( groupPart.size() < 2 )
+			return false;
+
+		RootMap partOfRoot;
+		for( const auto& rootPair : rootFirst )
+			partOfRoot[ rootPair.first ] = partOf[ rootPair.second ];
+		PartList parts( groupPart.size() );
+		for( std::size_t i = 0; i < constraints.size(); ++i )
+			parts[ partOf[ i ] ].constraints.push_back( i );
+		for( const auto& varPair : m_vars )
+		{
+			auto part_it = partOfRoot.find( m_components.find( varPair.second.id() ) );
+			if( part_it != partOfRoot.end() )
+				parts[ part_it->second ].vars.push_back( std::make_pair( varPair.first, varPair.second ) );
+		}
+		gatherParts( parts, partOfRoot );
+
+		m_executor->run( parts.size(), [ &parts, &constraints ]( std::size_t index )
+		{
+			Part& part = parts[ index ];
+			try
+			{
+				SolverImpl& impl = preparePart( part );
+				BatchGuard guard( impl );
+				for( std::size_t i : part.constraints )
+				{
+					Symbol::Id tick = impl.m_id_tick;
+					impl.insertConstraint( constraints[ i ] );
+					part.drawn.push_back( std::make_pair( impl.m_id_tick - tick, impl.m_batch_released.size() ) );
+				}
+				impl.optimize( *impl.m_objective );
+				part.released.assign( impl.m_batch_released.begin(), impl.m_batch_released.end() );
+			}
+			catch( ... )
+			{
+				part.failed = true;
+			}
+		} );
+		for( const Part& part : parts )
+		{
+			if( part.failed )
+				return false;
+		}
+
+		// Give out the new ids in the order of the constraints, as the
+		// serial solver draws them, and release ids in the same order.
+		IdList released( resource() );
+		std::vector<std::size_t> next( parts.size(), 0 );
+		std::vector<std::size_t> releasedNext( parts.size(), 0 );
+		for( std::size_t i = 0; i < constraints.size(); ++i )
+		{
+			std::size_t p = partOf[ i ];
+			Part& part = parts[ p ];
+			const auto& drawn = part.drawn[ next[ p ]++ ];
+			for( Symbol::Id k = 0; k < drawn.first; ++k )
+				part.fresh.push_back( m_id_tick++ );
+			for( ; releasedNext[ p ] < drawn.second; ++releasedNext[ p ] )
+				released.push_back( globalId( part, part.released[ releasedNext[ p ] ] ) );
+		}
+
+		mergeParts( parts, partOfRoot );
+		for( Part& part : parts )
+		{
+			for( const auto& cnPair : part.impl->m_cns )
+			{
+				Tag tag;
+				tag.marker = globalSymbol( part, cnPair.second.marker );
+				tag.other = globalSymbol( part, cnPair.second.other );
+				m_cns[ cnPair.first ] = tag;
+			}
+			for( const auto& varPair : part.impl->m_vars )
+			{
+				if( varPair.second.id() > part.ids.size() )
+					insertVariable( varPair.first, globalSymbol( part, varPair.second ) );
+			}
+			part.impl.reset();
+		}
+		m_free_ids.insert( m_free_ids.end(), released.begin(), released.end() );
+		return true;
+	}
+
+	/* Dual optimize the independent parts of the infeasible rows apart.
+
+	Each component of the tableau holding an infeasible row is a part,
+	with the pending rows of the component in their order. A pivot only
+	changes its own component, so the parts reach the same tableau as
+	the serial dual optimization. Returns false, leaving the solver
+	untouched, when fewer than two components are infeasible or when a
+	part fails, so that the serial optimization reports the failure.
+
+	*/
+	bool dualOptimizeInParts()
+	{
+		if( m_infeasible_rows.size() < 2 )
+			return false;
+		refreshComponents();
+		RootMap partOfRoot;
+		for( const Symbol& leaving : m_infeasible_rows )
+		{
+			auto it = m_rows.find( leaving );
+			if( it != m_rows.end() && !nearZero( it->second->constant() ) &&
+				it->second->constant() < T( 0 ) )
+				partOfRoot.insert( std::make_pair( m_components.find( leaving.id() ), partOfRoot.size() ) );
+		}
+		if( partOfRoot.size() < 2 )
+			return false;
+
+		PartList parts( partOfRoot.size() );
+		for( const Symbol& leaving : m_infeasible_rows )
+		{
+			auto part_it = partOfRoot.find( m_components.find( leaving.id() ) );
+			if( part_it != partOfRoot.end() )
+				parts[ part_it->second ].infeasible.push_back( leaving );
+		}
+		gatherParts( parts, partOfRoot );
+
+		m_executor->run( parts.size(), [ &parts ]( std::size_t index )
+		{
+			Part& part = parts[ index ];
+			try
+			{
+				preparePart( part ).dualOptimize();
+			}
+			catch( ... )
+			{
+				part.failed = true;
+			}
+		} );
+		for( const Part& part : parts )
+		{
+			if( part.failed )
+				return false;
+		}
+		mergeParts( parts, partOfRoot );
+		m_infeasible_rows.clear();
+		return true;
+	}
 
-		// If chooseSubject could not find a valid entering symbol, one
-		// last option is available if the entire row is composed of
-		// dummy variables. If the constant of the row is zero, then
-		// this represents redundant constraints and the new dummy
-		// marker can enter the basis. If the constant is non-zero,
-		// then it represents an unsatisfiable constraint.
-		if( subject.type() == Symbol::Invalid && allDummies( *rowptr ) )
+	/* Gather the rows and the objective cells of the parts.
+
+	*/
+	void gatherParts( PartList& parts, const RootMap& partOfRoot )
+	{
+		for( const auto& rowPair : m_rows )
 		{
-			if( !nearZero( rowptr->constant() ) )
-				throw UnsatisfiableConstraint( constraint );
-			else
-				subject = tag.marker;
+			auto part_it = partOfRoot.find( m_components.find( rowPair.first.id() ) );
+			if( part_it != partOfRoot.end() )
+				parts[ part_it->second ].rows.push_back( std::make_pair( rowPair.first, rowPair.second ) );
+		}
+		const typename Row::SymbolVector& syms( m_objective->symbols() );
+		const typename Row::CoeffVector& coeffs( m_objective->coefficients() );
+		for( std::size_t i = 0, n = syms.size(); i < n; ++i )
+		{
+			auto part_it = partOfRoot.find( m_components.find( syms[ i ].id() ) );
+			if( part_it != partOfRoot.end() )
+				parts[ part_it->second ].objective.push_back( std::make_pair( syms[ i ], coeffs[ i ] ) );
 		}
+	}
 
-		// If an entering symbol still isn't found, then the row must
-		// be added using an artificial variable. If that fails, then
-		// the row represents an unsatisfiable constraint.
-		if( subject.type() == Symbol::Invalid )
+	/* Copy a part into a solver of its own.
+
+	This runs in a task, so only the gathered part is read.
+
+	*/
+	static SolverImpl& preparePart( Part& part )
+	{
+		std::vector<Symbol::Id>& ids = part.ids;
+		for( const auto& rowPair : part.rows )
 		{
-			if( !addWithArtificialVariable( *rowptr ) )
-				throw UnsatisfiableConstraint( constraint );
+			ids.push_back( rowPair.first.id() );
+			for( const Symbol& sym : rowPair.second->symbols() )
+				ids.push_back( sym.id() );
 		}
-		else
+		for( const auto& cell : part.objective )
+			ids.push_back( cell.first.id() );
+		for( const auto& varPair : part.vars )
+			ids.push_back( varPair.second.id() );
+		for( const Symbol& sym : part.infeasible )
+			ids.push_back( sym.id() );
+		std::sort( ids.begin(), ids.end() );
+		ids.erase( std::unique( ids.begin(), ids.end() ), ids.end() );
+
+		auto local = [ &ids ]( const Symbol& sym ) -> Symbol
 		{
-			rowptr->solveFor( subject );
-			substitute( subject, *rowptr );
-			m_rows[ subject ] = rowptr.release();
+			auto it = std::lower_bound( ids.begin(), ids.end(), sym.id() );
+			return Symbol( sym.type(), Symbol::Id( it - ids.begin() ) + 1 );
+		};
+
+		part.impl.reset( new SolverImpl() );
+		SolverImpl& impl = *part.impl;
+		impl.m_id_tick = Symbol::Id( ids.size() ) + 1;
+		for( const auto& rowPair : part.rows )
+		{
+			Row* row = impl.m_pool.acquire( *rowPair.second );
+			row->renumber( local );
+			impl.insertRow( local( rowPair.first ), row );
+		}
+		for( const auto& cell : part.objective )
+			impl.m_objective->insert( local( cell.first ), cell.second );
+		for( const auto& varPair : part.vars )
+		{
+			Symbol symbol( local( varPair.second ) );
+			impl.m_vars[ varPair.first ] = symbol;
+			impl.m_symbol_vars.insert( typename SymbolVarMap::value_type( symbol, varPair.first ) );
 		}
+		for( const Symbol& sym : part.infeasible )
+			impl.m_infeasible_rows.push_back( local( sym ) );
+		return impl;
+	}
 
-		m_cns[ constraint ] = tag;
+	/* Map the id of a symbol of the solver of a part back to the tableau.
 
-		// Optimizing after each constraint is added performs less
-		// aggregate work due to a smaller average system size. It
-		// also ensures the solver remains in a consistent state.
-		optimize( *m_objective );
+	*/
+	static Symbol::Id globalId( const Part& part, Symbol::Id id )
+	{
+		if( id <= part.ids.size() )
+			return part.ids[ id - 1 ];
+		return part.fresh[ id - part.ids.size() - 1 ];
 	}
 
-	/* Remove a constraint from the solver.
+	static Symbol globalSymbol( const Part& part, const Symbol& sym )
+	{
+		if( sym.type() == Symbol::Invalid )
+			return sym;
+		return Symbol( sym.type(), globalId( part, sym.id() ) );
+	}
 
-	Throws
-	------
-	UnknownConstraint
-		The given constraint has not been added to the solver.
+	/* Replace the rows and the objective cells of the parts with those of
+	their solvers.
+
+	The ids are mapped back in their order, so the cells stay sorted.
 
 	*/
-	void removeConstraint( const Constraint& constraint )
+	void mergeParts( PartList& parts, const RootMap& partOfRoot )
 	{
-		auto cn_it = m_cns.find( constraint );
-		if( cn_it == m_cns.end() )
-			throw UnknownConstraint( constraint );
+		std::vector<std::pair<Symbol, T>> cells;
+		T constant = m_objective->constant();
+		const typename Row::SymbolVector& syms( m_objective->symbols() );
+		const typename Row::CoeffVector& coeffs( m_objective->coefficients() );
+		for( std::size_t i = 0, n = syms.size(); i < n; ++i )
+		{
+			if( partOfRoot.find( m_components.find( syms[ i ].id() ) ) == partOfRoot.end() )
+				cells.push_back( std::make_pair( syms[ i ], coeffs[ i ] ) );
+		}
+		for( const Part& part : parts )
+		{
+			const Row& objective = *part.impl->m_objective;
+			for( std::size_t i = 0, n = objective.size(); i < n; ++i )
+				cells.push_back( std::make_pair( globalSymbol( part, objective.symbols()[ i ] ), objective.coefficients()[ i ] ) );
+			constant += objective.constant();
+		}
+		std::sort( cells.begin(), cells.end(), []( const std::pair<Symbol, T>& a, const std::pair<Symbol, T>& b )
+		{
+			return a.first < b.first;
+		} );
+		std::vector<Symbol> symbols( cells.size() );
+		std::vector<T> coefficients( cells.size() );
+		for( std::size_t i = 0; i < cells.size(); ++i )
+		{
+			symbols[ i ] = cells[ i ].first;
+			coefficients[ i ] = cells[ i ].second;
+		}
+		m_objective->assign( symbols.data(), coefficients.data(), cells.size(), constant );
 
-		Tag tag( cn_it->second );
-		m_cns.erase( cn_it );
+		for( Part& part : parts )
+		{
+			for( const auto& rowPair : part.rows )
+				m_pool.own( eraseRow( m_rows.find( rowPair.first ) ) );
+			auto global = [ &part ]( const Symbol& sym ) { return globalSymbol( part, sym ); };
+			for( const auto& rowPair : part.impl->m_rows )
+			{
+				Symbol basic( global( rowPair.first ) );
+				Row* row = m_pool.acquire( *rowPair.second );
+				row->renumber( global );
+				for( const Symbol& sym : row->symbols() )
+					m_components.unite( basic.id(), sym.id() );
+				insertRow( basic, row );
+			}
+		}
+	}
 
-		// Remove the error effects from the objective function
-		// *before* pivoting, or substitutions into the objective
-		// will lead to incorrect solver results.
-		removeConstraintEffects( constraint, tag );
+	/* Remove the row of the marker of a constraint from the tableau.
+
+	If the marker is basic, its row is simply dropped. Otherwise, the
+	marker is pivoted into the basis and then its row is dropped.
 
-		// If the marker is basic, simply drop the row. Otherwise,
-		// pivot the marker into the basis and then drop the row.
+	*/
+	void removeMarkerRow( const Tag& tag )
+	{
+		m_components.setStale();
 		auto row_it = m_rows.find( tag.marker );
 		if( row_it != m_rows.end() )
 		{
-			std::unique_ptr<Row> rowptr( row_it->second );
-			m_rows.erase( row_it );
+			typename RowPool::Ptr rowptr( m_pool.own( eraseRow( row_it ) ) );
 		}
 		else
 		{
@@ -168,187 +2208,246 @@ public:
 			if( row_it == m_rows.end() )
 				throw InternalSolverError( "failed to find leaving row" );
 			Symbol leaving( row_it->first );
-			std::unique_ptr<Row> rowptr( row_it->second );
-			m_rows.erase( row_it );
+			typename RowPool::Ptr rowptr( m_pool.own( eraseRow( row_it ) ) );
 			rowptr->solveFor( leaving, tag.marker );
 			substitute( tag.marker, *rowptr );
 		}
+	}
 
-		// Optimizing after each constraint is removed ensures that the
-		// solver remains consistent. It makes the solver api easier to
-		// use at a small tradeoff for speed.
-		optimize( *m_objective );
+	void clearRows()
+	{
+		for( auto& rowPair : m_rows )
+			releaseRow( rowPair.second );
+		m_rows.clear();
+		m_columns.clear();
+		++m_basis_version;
 	}
 
-	/* Test whether a constraint has been added to the solver.
+	/* Join the components of the symbols of a new row.
 
 	*/
-	bool hasConstraint( const Constraint& constraint ) const
+	void uniteComponents( const Row& row )
 	{
-		return m_cns.find( constraint ) != m_cns.end();
+		const auto& symbols = row.symbols();
+		for( std::size_t i = 1; i < symbols.size(); ++i )
+			m_components.unite( symbols[ 0 ].id(), symbols[ i ].id() );
 	}
 
-	/* Add an edit variable to the solver.
+	/* Rebuild the component index from the rows if it is stale.
 
-	This method should be called before the `suggestValue` method is
-	used to supply a suggested value for the given edit variable.
+	*/
+	void refreshComponents()
+	{
+		if( !m_components.stale() )
+			return;
+		m_components.clear();
+		for( const auto& rowPair : m_rows )
+		{
+			for( const Symbol& sym : rowPair.second->symbols() )
+				m_components.unite( rowPair.first.id(), sym.id() );
+		}
+	}
 
-	Throws
-	------
-	DuplicateEditVariable
-		The given edit variable has already been added to the solver.
+	/* Add a row to the tableau as the row of the given basic symbol.
 
-	BadRequiredStrength
-		The given strength is >= required.
+	The tableau takes ownership of the row and the column index is
+	updated with the symbols of the row.
 
 	*/
-	void addEditVariable( const Variable& variable, double strength )
+	void insertRow( const Symbol& basic, Row* row )
 	{
-		if( m_edits.find( variable ) != m_edits.end() )
-			throw DuplicateEditVariable( variable );
-		strength = strength::clip( strength );
-		if( strength == strength::required )
-			throw BadRequiredStrength();
-		Constraint cn( Expression( variable ), OP_EQ, strength );
-		addConstraint( cn );
-		EditInfo info;
-		info.tag = m_cns[ cn ];
-		info.constraint = cn;
-		info.constant = 0.0;
-		m_edits[ variable ] = info;
+		if( mustLogRow( basic ) )
+			logRow( basic, nullptr );
+		m_rows[ basic ] = row;
+		for( const Symbol& sym : row->symbols() )
+			m_columns.add( sym, basic );
+		markChanged( basic );
+		++m_basis_version;
 	}
 
-	/* Remove an edit variable from the solver.
+	/* Remove a row from the tableau and return it.
 
-	Throws
-	------
-	UnknownEditVariable
-		The given edit variable has not been added to the solver.
+	The caller takes ownership of the returned row and the column index
+	is updated to forget the symbols of the row. A row shared with a
+	clone of the solver, or kept by the log of a transaction, is returned
+	as a private copy.
 
 	*/
-	void removeEditVariable( const Variable& variable )
+	Row* eraseRow( typename RowMap::iterator it )
 	{
-		auto it = m_edits.find( variable );
-		if( it == m_edits.end() )
-			throw UnknownEditVariable( variable );
-		removeConstraint( it->second.constraint );
-		m_edits.erase( it );
+		Symbol basic( it->first );
+		Row* row = it->second;
+		m_rows.erase( it );
+		for( const Symbol& sym : row->symbols() )
+			m_columns.remove( sym, basic );
+		markChanged( basic );
+		++m_basis_version;
+		if( mustLogRow( basic ) )
+		{
+			logRow( basic, row );
+			row = m_pool.acquire( *row );
+		}
+		else if( row->shared() )
+		{
+			Row* copy = m_pool.acquire( *row );
+			releaseRow( row );
+			row = copy;
+		}
+		return row;
 	}
 
-	/* Test whether an edit variable has been added to the solver.
+	/* Get a row of the tableau which can be modified.
+
+	A row shared with a clone of the solver is replaced in the tableau
+	by a private copy, which changes the basis version since the cached
+	responses may hold the shared row. Likewise, the first change of a
+	row in a transaction logs the row and replaces it by a copy.
 
 	*/
-	bool hasEditVariable( const Variable& variable ) const
+	Row* ownRow( const Symbol& basic, Row*& row )
 	{
-		return m_edits.find( variable ) != m_edits.end();
+		if( mustLogRow( basic ) )
+		{
+			logRow( basic, row );
+			row = m_pool.acquire( *row );
+			++m_basis_version;
+		}
+		else if( row->shared() )
+		{
+			Row* copy = m_pool.acquire( *row );
+			releaseRow( row );
+			row = copy;
+			++m_basis_version;
+		}
+		return row;
 	}
 
-	/* Suggest a value for the given edit variable.
+	/* Test whether the row of a basic symbol must be logged before it is
+	changed, which is the case once per transaction.
 
-	This method should be used after an edit variable as been added to
-	the solver in order to suggest the value for that variable.
+	*/
+	bool mustLogRow( const Symbol& basic ) const
+	{
+		if( m_transactions.empty() )
+			return false;
+		return basic.id() >= m_row_levels.size() ||
+			m_row_levels[ basic.id() ] != m_transactions.size();
+	}
 
-	Throws
-	------
-	UnknownEditVariable
-		The given edit variable has not been added to the solver.
+	/* Log the row of a basic symbol, null if the symbol is not basic, in
+	the innermost transaction. The log takes ownership of the row.
 
 	*/
-	void suggestValue( const Variable& variable, double value )
+	void logRow( const Symbol& basic, Row* row )
 	{
-		auto it = m_edits.find( variable );
-		if( it == m_edits.end() )
-			throw UnknownEditVariable( variable );
+		if( basic.id() >= m_row_levels.size() )
+			m_row_levels.resize( basic.id() + 1, 0 );
+		std::size_t& level = m_row_levels[ basic.id() ];
+		m_transactions.back().rows.push_back( RowChange{ basic, row, level } );
+		level = m_transactions.size();
+	}
 
-		DualOptimizeGuard guard( *this );
-		EditInfo& info = it->second;
-		double delta = value - info.constant;
-		info.constant = value;
+	void logConstraint( const Constraint& constraint, const Tag& tag, bool removed )
+	{
+		if( !m_transactions.empty() )
+			m_transactions.back().constraints.push_back( CnChange{ constraint, tag, removed } );
+	}
 
-		// Check first if the positive error variable is basic.
-		auto row_it = m_rows.find( info.tag.marker );
-		if( row_it != m_rows.end() )
-		{
-			if( row_it->second->add( -delta ) < 0.0 )
-				m_infeasible_rows.push_back( row_it->first );
-			return;
-		}
+	void logEdit( typename EditChange::Kind kind, const Variable& variable, const EditInfo& info )
+	{
+		if( !m_transactions.empty() )
+			m_transactions.back().edits.push_back(
+				EditChange{ variable, info.tag, info.constraint, info.constant, info.level, kind } );
+	}
 
-		// Check next if the negative error variable is basic.
-		row_it = m_rows.find( info.tag.other );
-		if( row_it != m_rows.end() )
-		{
-			if( row_it->second->add( delta ) < 0.0 )
-				m_infeasible_rows.push_back( row_it->first );
-			return;
-		}
+	/* Give up a row of the tableau, which goes back to the pool unless it
+	is still held by a clone of the solver.
 
-		// Otherwise update each row where the error variables exist.
-		for (const auto & rowPair : m_rows)
-		{
-			double coeff = rowPair.second->coefficientFor( info.tag.marker );
-			if( coeff != 0.0 &&
-				rowPair.second->add( delta * coeff ) < 0.0 &&
-				rowPair.first.type() != Symbol::External )
-				m_infeasible_rows.push_back( rowPair.first );
-		}
+	*/
+	void releaseRow( Row* row )
+	{
+		if( row->release() )
+			m_pool.release( row );
 	}
 
-	/* Update the values of the external solver variables.
+	/* Record that the value of the given symbol may have changed.
+
+	Only the external symbols are recorded, once until the next update.
 
 	*/
-	void updateVariables()
+	void markChanged( const Symbol& symbol )
 	{
-		auto row_end = m_rows.end();
+		if( symbol.type() != Symbol::External )
+			return;
+		if( symbol.id() >= m_changed_flags.size() )
+			m_changed_flags.resize( symbol.id() + 1, 0 );
+		if( m_changed_flags[ symbol.id() ] )
+			return;
+		m_changed_flags[ symbol.id() ] = 1;
+		m_changed.push_back( symbol );
+	}
 
-		for (auto &varPair : m_vars)
-		{
-			Variable& var = varPair.first;
-			auto row_it = m_rows.find( varPair.second );
-			if( row_it == row_end )
-				var.setValue( 0.0 );
-			else
-				var.setValue( row_it->second->constant() );
-		}
+	/* Forget the changed symbols, once all the variables are updated.
+
+	*/
+	void clearChanged()
+	{
+		for( const Symbol& sym : m_changed )
+			m_changed_flags[ sym.id() ] = 0;
+		m_changed.clear();
 	}
 
-	/* Reset the solver to the empty starting condition.
+	/* Create a symbol of the given type.
 
-	This method resets the internal solver state to the empty starting
-	condition, as if no constraints or edit variables have been added.
-	This can be faster than deleting the solver and creating a new one
-	when the entire system must change, since it can avoid unecessary
-	heap (de)allocations.
+	The ids released by removed constraints are reused before new ones
+	are drawn, so the ids stay bounded under add/remove churn. A batch
+	of constraints run on the executor only draws new ids, see BatchGuard.
 
 	*/
-	void reset()
+	Symbol newSymbol( Symbol::Type type )
 	{
-		clearRows();
-		m_cns.clear();
-		m_vars.clear();
-		m_edits.clear();
-		m_infeasible_rows.clear();
-		m_objective.reset( new Row() );
-		m_artificial.reset();
-		m_id_tick = 1;
+		if( m_batch || m_free_ids.empty() )
+			return Symbol( type, m_id_tick++ );
+		Symbol::Id id = m_free_ids.back();
+		m_free_ids.pop_back();
+		return Symbol( type, id );
 	}
 
-	SolverImpl& operator=( const SolverImpl& ) = delete;
-
-	SolverImpl& operator=( SolverImpl&& ) = delete;
+	/* Return the id of a symbol to the free list.
 
-private:
+	This is a no-op for an invalid symbol and for a symbol which is
+	still in use by the tableau or the objective function.
 
-	struct RowDeleter
+	*/
+	void releaseSymbol( const Symbol& symbol )
 	{
-		template<typename T>
-		void operator()( T& pair ) { delete pair.second; }
-	};
+		if( symbol.type() == Symbol::Invalid ||
+			m_rows.find( symbol ) != m_rows.end() ||
+			!m_columns.rows( symbol ).empty() ||
+			m_objective->coefficientFor( symbol ) != T( 0 ) )
+			return;
+		// A rollback could bring the symbol back, so its id is only
+		// reused once the transactions are committed.
+		if( !m_transactions.empty() )
+			m_transactions.back().released.push_back( symbol.id() );
+		else if( m_batch )
+			m_batch_released.push_back( symbol.id() );
+		else
+			m_free_ids.push_back( symbol.id() );
+	}
 
-	void clearRows()
+	/* Compact the symbol ids once most of them are free.
+
+	The batches run on the executor draw fresh ids, so the ids they
+	release pile up in the free list. Compacting once the free ids
+	outnumber the others keeps the ids below twice the number of live
+	symbols, at an amortized constant cost per id.
+
+	*/
+	void trimFreeIds()
 	{
-		std::for_each( m_rows.begin(), m_rows.end(), RowDeleter() );
-		m_rows.clear();
+		if( m_free_ids.size() * 2 > std::size_t( m_id_tick - 1 ) )
+			compact();
 	}
 
 	/* Get the symbol for the given variable.
@@ -361,11 +2460,25 @@ private:
 		auto it = m_vars.find( variable );
 		if( it != m_vars.end() )
 			return it->second;
-		Symbol symbol( Symbol::External, m_id_tick++ );
-		m_vars[ variable ] = symbol;
+		Symbol symbol( newSymbol( Symbol::External ) );
+		insertVariable( variable, symbol );
 		return symbol;
 	}
 
+	/* Give a symbol to a variable which has none.
+
+	*/
+	void insertVariable( const Variable& variable, const Symbol& symbol )
+	{
+		m_vars[ variable ] = symbol;
+		m_symbol_vars.insert( typename SymbolVarMap::value_type( symbol, variable ) );
+		markChanged( symbol );
+		if( m_pull_values )
+			Variable( variable ).setResolver( this, symbol.id() );
+		if( !m_transactions.empty() )
+			m_transactions.back().variables.push_back( variable );
+	}
+
 	/* Create a new Row object for the given constraint.
 
 	The terms in the constraint will be converted to cells in the row.
@@ -383,10 +2496,10 @@ private:
 	for tracking the movement of the constraint in the tableau.
 
 	*/
-	std::unique_ptr<Row> createRow( const Constraint& constraint, Tag& tag )
+	typename RowPool::Ptr createRow( const Constraint& constraint, Tag& tag )
 	{
 		const Expression& expr( constraint.expression() );
-		std::unique_ptr<Row> row( new Row( expr.constant() ) );
+		typename RowPool::Ptr row( m_pool.own( m_pool.acquire( T( expr.constant() ) ) ) );
 
 		// Substitute the current basic variables into the row.
 		for (const auto &term : expr.terms())
@@ -396,28 +2509,30 @@ private:
 				Symbol symbol( getVarSymbol( term.variable() ) );
 				auto row_it = m_rows.find( symbol );
 				if( row_it != m_rows.end() )
-					row->insert( *row_it->second, term.coefficient() );
+					row->insert( *row_it->second, T( term.coefficient() ) );
 				else
-					row->insert( symbol, term.coefficient() );
+					row->insert( symbol, T( term.coefficient() ) );
 			}
 		}
 
-		// Add the necessary slack, error, and dummy variables.
+		// Add the necessary slack, error, and dummy variables. The strength
+		// is repacked for the tiers of the scalar type.
+		T strength = strength::convert<T>( constraint.strength() );
 		switch( constraint.op() )
 		{
 			case OP_LE:
 			case OP_GE:
 			{
-				double coeff = constraint.op() == OP_LE ? 1.0 : -1.0;
-				Symbol slack( Symbol::Slack, m_id_tick++ );
+				T coeff = constraint.op() == OP_LE ? T( 1 ) : T( -1 );
+				Symbol slack( newSymbol( Symbol::Slack ) );
 				tag.marker = slack;
 				row->insert( slack, coeff );
 				if( constraint.strength() < strength::required )
 				{
-					Symbol error( Symbol::Error, m_id_tick++ );
+					Symbol error( newSymbol( Symbol::Error ) );
 					tag.other = error;
 					row->insert( error, -coeff );
-					m_objective->insert( error, constraint.strength() );
+					m_objective->insert( error, strength );
 				}
 				break;
 			}
@@ -425,18 +2540,18 @@ private:
 			{
 				if( constraint.strength() < strength::required )
 				{
-					Symbol errplus( Symbol::Error, m_id_tick++ );
-					Symbol errminus( Symbol::Error, m_id_tick++ );
+					Symbol errplus( newSymbol( Symbol::Error ) );
+					Symbol errminus( newSymbol( Symbol::Error ) );
 					tag.marker = errplus;
 					tag.other = errminus;
-					row->insert( errplus, -1.0 ); // v = eplus - eminus
-					row->insert( errminus, 1.0 ); // v - eplus + eminus = 0
-					m_objective->insert( errplus, constraint.strength() );
-					m_objective->insert( errminus, constraint.strength() );
+					row->insert( errplus, T( -1 ) ); // v = eplus - eminus
+					row->insert( errminus, T( 1 ) ); // v - eplus + eminus = 0
+					m_objective->insert( errplus, strength );
+					m_objective->insert( errminus, strength );
 				}
 				else
 				{
-					Symbol dummy( Symbol::Dummy, m_id_tick++ );
+					Symbol dummy( newSymbol( Symbol::Dummy ) );
 					tag.marker = dummy;
 					row->insert( dummy );
 				}
@@ -445,7 +2560,7 @@ private:
 		}
 
 		// Ensure the row as a positive constant.
-		if( row->constant() < 0.0 )
+		if( row->constant() < T( 0 ) )
 			row->reverseSign();
 
 		return row;
@@ -464,38 +2579,38 @@ private:
 
 	If a subject cannot be found, an invalid symbol will be returned.
 
+	The external symbols are ordered first in a row, so only the first
+	symbol of the row needs to be checked.
+
 	*/
 	Symbol chooseSubject( const Row& row, const Tag& tag ) const
 	{
-		for (const auto &cellPair : row.cells())
-		{
-			if( cellPair.first.type() == Symbol::External )
-				return cellPair.first;
-		}
+		if( !row.empty() && row.symbols().front().type() == Symbol::External )
+			return row.symbols().front();
 		if( tag.marker.type() == Symbol::Slack || tag.marker.type() == Symbol::Error )
 		{
-			if( row.coefficientFor( tag.marker ) < 0.0 )
+			if( row.coefficientFor( tag.marker ) < T( 0 ) )
 				return tag.marker;
 		}
 		if( tag.other.type() == Symbol::Slack || tag.other.type() == Symbol::Error )
 		{
-			if( row.coefficientFor( tag.other ) < 0.0 )
+			if( row.coefficientFor( tag.other ) < T( 0 ) )
 				return tag.other;
 		}
 		return Symbol();
 	}
 
- 	/* Add the row to the tableau using an artificial variable.
+	/* Add the row to the tableau using an artificial variable.
 
 	This will return false if the constraint cannot be satisfied.
 
- 	*/
- 	bool addWithArtificialVariable( const Row& row )
- 	{
+	*/
+	bool addWithArtificialVariable( const Row& row )
+	{
 		// Create and add the artificial variable to the tableau
-		Symbol art( Symbol::Slack, m_id_tick++ );
-		m_rows[ art ] = new Row( row );
-		m_artificial.reset( new Row( row ) );
+		Symbol art( newSymbol( Symbol::Slack ) );
+		insertRow( art, m_pool.acquire( row ) );
+		m_artificial.reset( m_pool.acquire( row ) );
 
 		// Optimize the artificial objective. This is successful
 		// only if the artificial objective is optimized to zero.
@@ -508,40 +2623,50 @@ private:
 		auto it = m_rows.find( art );
 		if( it != m_rows.end() )
 		{
-			std::unique_ptr<Row> rowptr( it->second );
-			m_rows.erase( it );
-			if( rowptr->cells().empty() )
+			typename RowPool::Ptr rowptr( m_pool.own( eraseRow( it ) ) );
+			if( rowptr->empty() )
+			{
+				releaseSymbol( art );
 				return success;
+			}
 			Symbol entering( anyPivotableSymbol( *rowptr ) );
 			if( entering.type() == Symbol::Invalid )
 				return false;  // unsatisfiable (will this ever happen?)
 			rowptr->solveFor( art, entering );
 			substitute( entering, *rowptr );
-			m_rows[ entering ] = rowptr.release();
+			insertRow( entering, rowptr.release() );
 		}
 
 		// Remove the artificial variable from the tableau.
-		for (auto &rowPair : m_rows)
-			rowPair.second->remove(art);
+		m_columns.take( art, m_column_scratch );
+		for( const Symbol& basic : m_column_scratch )
+			ownRow( basic, m_rows.find( basic )->second )->remove( art );
 
 		m_objective->remove( art );
+		releaseSymbol( art );
 		return success;
- 	}
+	}
 
 	/* Substitute the parametric symbol with the given row.
 
 	This method will substitute all instances of the parametric symbol
-	in the tableau and the objective function with the given row.
+	in the tableau and the objective function with the given row. Only
+	the rows listed in the column index for the symbol are visited.
 
 	*/
 	void substitute( const Symbol& symbol, const Row& row )
 	{
-		for( auto& rowPair : m_rows )
+		++m_basis_version;
+		m_columns.take( symbol, m_column_scratch );
+		for( const Symbol& basic : m_column_scratch )
 		{
-			rowPair.second->substitute( symbol, row );
-			if( rowPair.first.type() != Symbol::External &&
-				rowPair.second->constant() < 0.0 )
-				m_infeasible_rows.push_back( rowPair.first );
+			Row* target = ownRow( basic, m_rows.find( basic )->second );
+			ColumnObserver observer( m_columns, basic );
+			target->substitute( symbol, row, observer );
+			markChanged( basic );
+			if( basic.type() != Symbol::External &&
+				target->constant() < T( 0 ) )
+				m_infeasible_rows.push_back( basic );
 		}
 		m_objective->substitute( symbol, row );
 		if( m_artificial.get() )
@@ -571,11 +2696,10 @@ private:
 				throw InternalSolverError( "The objective is unbounded." );
 			// pivot the entering symbol into the basis
 			Symbol leaving( it->first );
-			Row* row = it->second;
-			m_rows.erase( it );
+			Row* row = eraseRow( it );
 			row->solveFor( leaving, entering );
 			substitute( entering, *row );
-			m_rows[ entering ] = row;
+			insertRow( entering, row );
 		}
 	}
 
@@ -584,7 +2708,8 @@ private:
 	The current state of the system should be such that the objective
 	function is optimal, but not feasible. This method will perform
 	an iteration of the dual simplex method to make the solution both
-	optimal and feasible.
+	optimal and feasible. With an executor, the independent parts of the
+	infeasible rows are optimized concurrently.
 
 	Throws
 	------
@@ -594,6 +2719,8 @@ private:
 	*/
 	void dualOptimize()
 	{
+		if( m_executor && dualOptimizeInParts() )
+			return;
 		while( !m_infeasible_rows.empty() )
 		{
 
@@ -601,35 +2728,61 @@ private:
 			m_infeasible_rows.pop_back();
 			auto it = m_rows.find( leaving );
 			if( it != m_rows.end() && !nearZero( it->second->constant() ) &&
-				it->second->constant() < 0.0 )
-			{
-				Symbol entering( getDualEnteringSymbol( *it->second ) );
-				if( entering.type() == Symbol::Invalid )
-					throw InternalSolverError( "Dual optimize failed." );
-				// pivot the entering symbol into the basis
-				Row* row = it->second;
-				m_rows.erase( it );
-				row->solveFor( leaving, entering );
-				substitute( entering, *row );
-				m_rows[ entering ] = row;
-			}
+				it->second->constant() < T( 0 ) )
+				dualPivot( it );
 		}
 	}
 
+	/* Pivot the basic symbol of a row out of the basis.
+
+	The entering symbol is selected with the ratio test of the dual
+	simplex method, so the objective stays optimal.
+
+	*/
+	void dualPivot( typename RowMap::iterator it )
+	{
+		Symbol leaving( it->first );
+		Symbol entering( getDualEnteringSymbol( *it->second ) );
+		if( entering.type() == Symbol::Invalid )
+			throw InternalSolverError( "Dual optimize failed." );
+		// pivot the entering symbol into the basis
+		Row* row = eraseRow( it );
+		row->solveFor( leaving, entering );
+		substitute( entering, *row );
+		insertRow( entering, row );
+	}
+
 	/* Compute the entering variable for a pivot operation.
 
 	This method will return first symbol in the objective function which
 	is non-dummy and has a coefficient less than zero. If no symbol meets
 	the criteria, it means the objective function is at a minimum, and an
-	invalid symbol is returned.
+	invalid symbol is returned. The dummy symbols are ordered last in a
+	row, so the scan stops at the first one.
+
+	A coefficient of the objective function must be less than minus the
+	objective epsilon of the scalar type times the largest coefficient of
+	the objective. The artificial objective is a plain row and not a sum
+	of strengths, so only its sign is tested.
 
 	*/
 	Symbol getEnteringSymbol( const Row& objective ) const
 	{
-		for (const auto &cellPair : objective.cells())
+		const typename Row::SymbolVector& syms( objective.symbols() );
+		const typename Row::CoeffVector& coeffs( objective.coefficients() );
+		T eps( 0 );
+		if( ScalarTraits<T>::objectiveEpsilon() > T( 0 ) && &objective == m_objective.get() )
+		{
+			for( const T& coeff : coeffs )
+				eps = std::max( eps, coeff < T( 0 ) ? -coeff : coeff );
+			eps *= ScalarTraits<T>::objectiveEpsilon();
+		}
+		for( std::size_t i = 0, n = syms.size(); i < n; ++i )
 		{
-			if( cellPair.first.type() != Symbol::Dummy && cellPair.second < 0.0 )
-				return cellPair.first;
+			if( syms[ i ].type() == Symbol::Dummy )
+				break;
+			if( coeffs[ i ] < -eps )
+				return syms[ i ];
 		}
 		return Symbol();
 	}
@@ -646,17 +2799,21 @@ private:
 	Symbol getDualEnteringSymbol( const Row& row ) const
 	{
 		Symbol entering;
-		double ratio = std::numeric_limits<double>::max();
-		for (const auto &cellPair : row.cells())
+		T ratio = std::numeric_limits<T>::max();
+		const typename Row::SymbolVector& syms( row.symbols() );
+		const typename Row::CoeffVector& coeffs( row.coefficients() );
+		for( std::size_t i = 0, n = syms.size(); i < n; ++i )
 		{
-			if( cellPair.second > 0.0 && cellPair.first.type() != Symbol::Dummy )
+			if( syms[ i ].type() == Symbol::Dummy )
+				break;
+			if( coeffs[ i ] > T( 0 ) )
 			{
-				double coeff = m_objective->coefficientFor( cellPair.first );
-				double r = coeff / cellPair.second;
+				T coeff = m_objective->coefficientFor( syms[ i ] );
+				T r = coeff / coeffs[ i ];
 				if( r < ratio )
 				{
 					ratio = r;
-					entering = cellPair.first;
+					entering = syms[ i ];
 				}
 			}
 		}
@@ -666,16 +2823,16 @@ private:
 	/* Get the first Slack or Error symbol in the row.
 
 	If no such symbol is present, and Invalid symbol will be returned.
+	The symbols of a row are ordered by type, so the first symbol past
+	the external ones is found with a binary search.
 
 	*/
 	Symbol anyPivotableSymbol( const Row& row ) const
 	{
-		for (const auto &cellPair : row.cells())
-		{
-			const Symbol& sym( cellPair.first );
-			if( sym.type() == Symbol::Slack || sym.type() == Symbol::Error )
-				return sym;
-		}
+		const typename Row::SymbolVector& syms( row.symbols() );
+		auto it = std::lower_bound( syms.begin(), syms.end(), Symbol( Symbol::Slack, 0 ) );
+		if( it != syms.end() && it->type() != Symbol::Dummy )
+			return *it;
 		return Symbol();
 	}
 
@@ -687,19 +2844,19 @@ private:
 	the objective function is unbounded.
 
 	*/
-	RowMap::iterator getLeavingRow( const Symbol& entering )
+	typename RowMap::iterator getLeavingRow( const Symbol& entering )
 	{
-		double ratio = std::numeric_limits<double>::max();
-		auto end = m_rows.end();
+		T ratio = std::numeric_limits<T>::max();
 		auto found = m_rows.end();
-		for( auto it = m_rows.begin(); it != end; ++it )
+		for( const Symbol& basic : m_columns.rows( entering ) )
 		{
-			if( it->first.type() != Symbol::External )
+			if( basic.type() != Symbol::External )
 			{
-				double temp = it->second->coefficientFor( entering );
-				if( temp < 0.0 )
+				auto it = m_rows.find( basic );
+				T temp = it->second->coefficientFor( entering );
+				if( temp < T( 0 ) )
 				{
-					double temp_ratio = -it->second->constant() / temp;
+					T temp_ratio = -it->second->constant() / temp;
 					if( temp_ratio < ratio )
 					{
 						ratio = temp_ratio;
@@ -730,27 +2887,28 @@ private:
 	the marker *should* exist somewhere in the tableau.
 
 	*/
-	RowMap::iterator getMarkerLeavingRow( const Symbol& marker )
+	typename RowMap::iterator getMarkerLeavingRow( const Symbol& marker )
 	{
-		const double dmax = std::numeric_limits<double>::max();
-		double r1 = dmax;
-		double r2 = dmax;
+		const T dmax = std::numeric_limits<T>::max();
+		T r1 = dmax;
+		T r2 = dmax;
 		auto end = m_rows.end();
 		auto first = end;
 		auto second = end;
 		auto third = end;
-		for( auto it = m_rows.begin(); it != end; ++it )
+		for( const Symbol& basic : m_columns.rows( marker ) )
 		{
-			double c = it->second->coefficientFor( marker );
-			if( c == 0.0 )
+			auto it = m_rows.find( basic );
+			T c = it->second->coefficientFor( marker );
+			if( c == T( 0 ) )
 				continue;
 			if( it->first.type() == Symbol::External )
 			{
 				third = it;
 			}
-			else if( c < 0.0 )
+			else if( c < T( 0 ) )
 			{
-				double r = -it->second->constant() / c;
+				T r = -it->second->constant() / c;
 				if( r < r1 )
 				{
 					r1 = r;
@@ -759,7 +2917,7 @@ private:
 			}
 			else
 			{
-				double r = it->second->constant() / c;
+				T r = it->second->constant() / c;
 				if( r < r2 )
 				{
 					r2 = r;
@@ -779,16 +2937,17 @@ private:
 	*/
 	void removeConstraintEffects( const Constraint& cn, const Tag& tag )
 	{
+		T strength = strength::convert<T>( cn.strength() );
 		if( tag.marker.type() == Symbol::Error )
-			removeMarkerEffects( tag.marker, cn.strength() );
+			removeMarkerEffects( tag.marker, strength );
 		if( tag.other.type() == Symbol::Error )
-			removeMarkerEffects( tag.other, cn.strength() );
+			removeMarkerEffects( tag.other, strength );
 	}
 
 	/* Remove the effects of an error marker on the objective function.
 
 	*/
-	void removeMarkerEffects( const Symbol& marker, double strength )
+	void removeMarkerEffects( const Symbol& marker, T strength )
 	{
 		auto row_it = m_rows.find( marker );
 		if( row_it != m_rows.end() )
@@ -799,25 +2958,43 @@ private:
 
 	/* Test whether a row is composed of all dummy variables.
 
+	The dummy symbols are ordered last in a row, so the row is made of
+	dummies only if its first symbol is one.
+
 	*/
 	bool allDummies( const Row& row ) const
 	{
-		for (const auto &rowPair : row.cells())
-		{
-			if( rowPair.first.type() != Symbol::Dummy )
-				return false;
-		}
-		return true;
+		return row.empty() || row.symbols().front().type() == Symbol::Dummy;
 	}
 
+	RowPool m_pool;
 	CnMap m_cns;
 	RowMap m_rows;
+	ColumnIndex m_columns;
+	ColumnIndex::RowList m_column_scratch;
+	ComponentIndex m_components;
 	VarMap m_vars;
+	SymbolVarMap m_symbol_vars;
 	EditMap m_edits;
-	std::vector<Symbol> m_infeasible_rows;
-	std::unique_ptr<Row> m_objective;
-	std::unique_ptr<Row> m_artificial;
+	SymbolList m_infeasible_rows;
+	typename RowPool::Ptr m_objective;
+	typename RowPool::Ptr m_artificial;
+	IdList m_free_ids;
+	SymbolList m_changed;
+	FlagList m_changed_flags;
+	SymbolList m_slot_symbols;
+	ValueList m_slot_values;
+	SlotList m_free_slots;
+	TransactionList m_transactions;
+	LevelList m_row_levels;  // the transaction which logged each basic row
+	IdList m_batch_released;  // the ids released by the open batch
+	Executor* m_executor;
 	Symbol::Id m_id_tick;
+	mutable std::size_t m_basis_version;  // changed with the basis, the row cells or by a clone
+	unsigned long long m_epoch;
+	bool m_defer_suggestions;
+	bool m_pull_values;
+	bool m_batch;
 };
 
 } // namespace impl
@@ -7,6 +7,8 @@
 |----------------------------------------------------------------------------*/
 #pragma once
 #include <algorithm>
+#include <cmath>
+#include "util.h"
 
 
 namespace kiwi
@@ -15,13 +17,30 @@ namespace kiwi
 namespace strength
 {
 
-inline double create( double a, double b, double c, double w = 1.0 )
+/* Create a strength for a solver computing with the scalar type T.
+
+The three tiers are packed with the factor of the scalar type, and each
+one is clipped to the limit of the type, see impl::ScalarTraits. With a
+float solver this keeps a weak tier from being rounded away by a strong
+one, so the strengths stay ordered.
+
+*/
+template <typename T>
+inline T create( double a, double b, double c, double w = 1.0 )
 {
+	const double tier = impl::ScalarTraits<T>::strengthTier();
+	const double limit = impl::ScalarTraits<T>::strengthLimit();
 	double result = 0.0;
-	result += std::max( 0.0, std::min( 1000.0, a * w ) ) * 1000000.0;
-	result += std::max( 0.0, std::min( 1000.0, b * w ) ) * 1000.0;
-	result += std::max( 0.0, std::min( 1000.0, c * w ) );
-	return result;
+	result += std::max( 0.0, std::min( limit, a * w ) ) * tier * tier;
+	result += std::max( 0.0, std::min( limit, b * w ) ) * tier;
+	result += std::max( 0.0, std::min( limit, c * w ) );
+	return T( result );
+}
+
+
+inline double create( double a, double b, double c, double w = 1.0 )
+{
+	return create<double>( a, b, c, w );
 }
 
 
@@ -39,6 +58,27 @@ inline double clip( double value )
 	return std::max( 0.0, std::min( required, value ) );
 }
 
+
+/* Convert a strength made by create to the scalar type T.
+
+The strength is split back into its three tiers, which are packed again
+for T. This is a plain conversion when T uses the tiers of double.
+
+*/
+template <typename T>
+inline T convert( double value )
+{
+	if( impl::ScalarTraits<T>::strengthTier() == 1000.0 )
+		return T( value );
+	if( value >= required )
+		return create<T>( 1000.0, 1000.0, 1000.0 );
+	double a = std::floor( value / 1000000.0 );
+	value -= a * 1000000.0;
+	double b = std::floor( value / 1000.0 );
+	value -= b * 1000.0;
+	return create<T>( a, b, value );
+}
+
 } // namespace strength
 
 } // namespace kiwi
@@ -0,0 +1,135 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "variable.h"
+
+
+namespace kiwi
+{
+
+namespace impl
+{
+
+template <typename T, typename Policy>
+class SolverImpl;
+
+} // namespace impl
+
+/* The solution of a system over a range of values of an edit variable.
+
+The values of the variables are piecewise linear in the value suggested
+for an edit variable. A sweep holds the breakpoints of the range and, for
+each segment between two breakpoints, the values of the variables at the
+start of the segment and their slopes. The solution for any value of the
+range is then a binary search followed by a multiply-add per variable.
+
+*/
+class Sweep
+{
+
+public:
+    Sweep() = default;
+
+    /* The variables of the solver, in the order of the values.
+
+    */
+    const std::vector<Variable> &variables() const
+    {
+        return m_variables;
+    }
+
+    /* The increasing breakpoints, one more than the segments.
+
+    */
+    const std::vector<double> &breakpoints() const
+    {
+        return m_breakpoints;
+    }
+
+    std::size_t segmentCount() const
+    {
+        return m_breakpoints.empty() ? 0 : m_breakpoints.size() - 1;
+    }
+
+    /* The segment holding a value, values out of the range belong to
+    the first or the last segment.
+
+    */
+    std::size_t segmentFor(double value) const
+    {
+        if (m_breakpoints.size() < 3)
+            return 0;
+        auto first = m_breakpoints.begin() + 1;
+        return std::size_t(std::upper_bound(first, m_breakpoints.end() - 1, value) - first);
+    }
+
+    /* The values of the variables at the start of a segment.
+
+    */
+    const double *offsets(std::size_t segment) const
+    {
+        return m_offsets.data() + segment * m_variables.size();
+    }
+
+    /* The derivatives of the variables in a segment.
+
+    */
+    const double *slopes(std::size_t segment) const
+    {
+        return m_slopes.data() + segment * m_variables.size();
+    }
+
+    /* Write the values of the variables for a value of the edit variable.
+
+    The buffer must hold a value per variable.
+
+    */
+    void evaluate(double value, double *out) const
+    {
+        if (m_breakpoints.empty())
+            return;
+        std::size_t segment = segmentFor(value);
+        const double *offset = offsets(segment);
+        const double *slope = slopes(segment);
+        double delta = value - m_breakpoints[segment];
+        for (std::size_t i = 0, n = m_variables.size(); i < n; ++i)
+            out[i] = offset[i] + slope[i] * delta;
+    }
+
+    /* Set the values of the variables for a value of the edit variable.
+
+    */
+    void apply(double value) const
+    {
+        if (m_breakpoints.empty())
+            return;
+        std::size_t segment = segmentFor(value);
+        const double *offset = offsets(segment);
+        const double *slope = slopes(segment);
+        double delta = value - m_breakpoints[segment];
+        for (std::size_t i = 0, n = m_variables.size(); i < n; ++i)
+        {
+            Variable var(m_variables[i]);
+            var.setValue(offset[i] + slope[i] * delta);
+        }
+    }
+
+private:
+    template <typename T, typename Policy>
+    friend class impl::SolverImpl;
+
+    std::vector<Variable> m_variables;
+    std::vector<double> m_breakpoints;
+    std::vector<double> m_offsets;
+    std::vector<double> m_slopes;
+};
+
+} // namespace kiwi
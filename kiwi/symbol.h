@@ -14,6 +14,13 @@ namespace kiwi
 namespace impl
 {
 
+/* A symbol of the tableau.
+
+The type is stored in the high bits of the id, so a symbol fits in 8 bytes
+and symbols are ordered by type first: the external symbols come first in a
+row, followed by the slack, error and dummy symbols.
+
+*/
 class Symbol
 {
 
@@ -30,39 +37,44 @@ public:
 		Dummy
 	};
 
-	Symbol() : m_id( 0 ), m_type( Invalid ) {}
+	Symbol() : m_value( 0 ) {}
 
-	Symbol( Type type, Id id ) : m_id( id ), m_type( type ) {}
+	Symbol( Type type, Id id ) : m_value( ( Id( type ) << TypeShift ) | id ) {}
 
 	~Symbol() = default;
 
 	Id id() const
 	{
-		return m_id;
+		return m_value & IdMask;
 	}
 
 	Type type() const
 	{
-		return m_type;
+		return static_cast<Type>( m_value >> TypeShift );
 	}
 
 private:
 
-	Id m_id;
-	Type m_type;
+	static const int TypeShift = 61;
+
+	static const Id IdMask = ( Id( 1 ) << TypeShift ) - 1;
+
+	Id m_value;
 
 	friend bool operator<( const Symbol& lhs, const Symbol& rhs )
 	{
-		return lhs.m_id < rhs.m_id;
+		return lhs.m_value < rhs.m_value;
 	}
 
 	friend bool operator==( const Symbol& lhs, const Symbol& rhs )
 	{
-		return lhs.m_id == rhs.m_id;
+		return lhs.m_value == rhs.m_value;
 	}
 
 };
 
+static_assert( sizeof( Symbol ) == 8, "a symbol should fit in 8 bytes" );
+
 } // namespace impl
 
 } // namespace kiwi
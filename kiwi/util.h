@@ -6,6 +6,7 @@
 | The full license is in the file LICENSE, distributed with this software.
 |----------------------------------------------------------------------------*/
 #pragma once
+#include <limits>
 
 namespace kiwi
 {
@@ -13,10 +14,108 @@ namespace kiwi
 namespace impl
 {
 
-inline bool nearZero(double value)
+/* The numerical properties of a scalar type of the solver.
+
+The epsilon is the magnitude below which a coefficient is considered to be
+zero. The objective epsilon plays the same role for the coefficients of the
+objective function, which are sums of strengths and carry the rounding
+errors of the largest ones, so it is relative to the largest coefficient
+of the objective. A strength packs three tiers (strong, medium and weak)
+in a single number, see strength::create: the tier factor is the ratio
+between two consecutive tiers and the tier limit the largest value of a
+tier.
+
+A float objective can therefore not tell apart the strengths which differ
+by less than about 4e-6 times its largest coefficient: with the default
+strong strength of 65536 in the objective, weak strengths below a weight
+of about 0.25 are ignored.
+
+*/
+template <typename T>
+struct ScalarTraits;
+
+template <>
+struct ScalarTraits<float>
+{
+    static float epsilon()
+    {
+        return 1.0e-5f;
+    }
+
+    // A few ulps of the largest coefficient: the rounding error of a sum
+    // of strong strengths of 65536 is 2^-8, which stays below the 0.25
+    // this gives and well below the weak strength.
+    static float objectiveEpsilon()
+    {
+        return 32.0f * std::numeric_limits<float>::epsilon();
+    }
+
+    // Three tiers of 256 levels fit in the 24 bits of the float mantissa,
+    // so every strength is exact and the tiers stay ordered.
+    static double strengthTier()
+    {
+        return 256.0;
+    }
+
+    static double strengthLimit()
+    {
+        return 255.0;
+    }
+};
+
+template <>
+struct ScalarTraits<double>
+{
+    static double epsilon()
+    {
+        return 1.0e-8;
+    }
+
+    static double objectiveEpsilon()
+    {
+        return 0.0;
+    }
+
+    static double strengthTier()
+    {
+        return 1000.0;
+    }
+
+    static double strengthLimit()
+    {
+        return 1000.0;
+    }
+};
+
+template <>
+struct ScalarTraits<long double>
+{
+    static long double epsilon()
+    {
+        return 1.0e-11L;
+    }
+
+    static long double objectiveEpsilon()
+    {
+        return 0.0L;
+    }
+
+    static double strengthTier()
+    {
+        return 1000.0;
+    }
+
+    static double strengthLimit()
+    {
+        return 1000.0;
+    }
+};
+
+template <typename T>
+inline bool nearZero(T value)
 {
-    const double eps = 1.0e-8;
-    return value < 0.0 ? -value < eps : value < eps;
+    const T eps = ScalarTraits<T>::epsilon();
+    return value < T(0) ? -value < eps : value < eps;
 }
 
 } // namespace impl
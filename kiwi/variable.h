@@ -6,6 +6,7 @@
 | The full license is in the file LICENSE, distributed with this software.
 |----------------------------------------------------------------------------*/
 #pragma once
+#include <functional>
 #include <memory>
 #include <string>
 #include "shareddata.h"
@@ -24,6 +25,26 @@ public:
         virtual ~Context() {} // LCOV_EXCL_LINE
     };
 
+    /* A solver which resolves the value of a variable on demand.
+
+    A variable attached to a resolver reads its value from the resolver
+    the first time it is accessed in each epoch of the resolver, and
+    caches it for the rest of the epoch. See BasicSolver::setPullValues.
+
+    */
+    class Resolver
+    {
+    public:
+        virtual ~Resolver() {} // LCOV_EXCL_LINE
+
+        // Get the current value of the variable with the given key. The
+        // resolver may have to solve the system first, which can throw.
+        virtual double resolve(unsigned long long key) = 0;
+
+        // Get the current epoch, which changes when the values may have.
+        virtual unsigned long long epoch() const = 0;
+    };
+
     Variable(Context *context = 0) : m_data(new VariableData("", context)) {}
 
     Variable(std::string name, Context *context = 0) : m_data(new VariableData(std::move(name), context)) {}
@@ -61,14 +82,47 @@ public:
         m_data->m_context.reset(context);
     }
 
+    // Get the value of the variable, resolving it first if the variable is
+    // attached to a resolver. Resolving may throw the errors of the solver.
     double value() const
     {
-        return m_data->m_value;
+        const VariableData *data = m_data.data();
+        if (data->m_resolver && data->m_epoch != data->m_resolver->epoch())
+        {
+            data->m_value = data->m_resolver->resolve(data->m_key);
+            data->m_epoch = data->m_resolver->epoch();
+        }
+        return data->m_value;
     }
 
     void setValue(double value)
     {
         m_data->m_value = value;
+        // A written value holds until the next epoch of the resolver.
+        if (m_data->m_resolver)
+            m_data->m_epoch = m_data->m_resolver->epoch();
+    }
+
+    // Get the value last written or resolved, without resolving it.
+    double cachedValue() const
+    {
+        return m_data->m_value;
+    }
+
+    Resolver *resolver() const
+    {
+        return m_data->m_resolver;
+    }
+
+    /* Attach the variable to a resolver under the given key, or detach it
+    with a null resolver. The variable then keeps its last value.
+
+    */
+    void setResolver(Resolver *resolver, unsigned long long key = 0)
+    {
+        m_data->m_resolver = resolver;
+        m_data->m_key = key;
+        m_data->m_epoch = 0;
     }
 
     // operator== is used for symbolics
@@ -89,18 +143,27 @@ private:
         VariableData(std::string name, Context *context) : SharedData(),
                                                                   m_name(std::move(name)),
                                                                   m_context(context),
-                                                                  m_value(0.0) {}
+                                                                  m_value(0.0),
+                                                                  m_resolver(nullptr),
+                                                                  m_key(0),
+                                                                  m_epoch(0) {}
 
         VariableData(const char *name, Context *context) : SharedData(),
                                                            m_name(name),
                                                            m_context(context),
-                                                           m_value(0.0) {}
+                                                           m_value(0.0),
+                                                           m_resolver(nullptr),
+                                                           m_key(0),
+                                                           m_epoch(0) {}
 
         ~VariableData() = default;
 
         std::string m_name;
         std::unique_ptr<Context> m_context;
-        double m_value;
+        mutable double m_value;  // cached when resolved
+        Resolver *m_resolver;
+        unsigned long long m_key;
+        mutable unsigned long long m_epoch;
 
     private:
         VariableData(const VariableData &other);
@@ -114,6 +177,23 @@ private:
     {
         return lhs.m_data < rhs.m_data;
     }
+
+    friend struct std::hash<Variable>;
 };
 
 } // namespace kiwi
+
+namespace std
+{
+
+// Hash a variable by identity, consistently with its ordering.
+template <>
+struct hash<kiwi::Variable>
+{
+    std::size_t operator()(const kiwi::Variable &variable) const
+    {
+        return std::hash<const void *>()(variable.m_data.data());
+    }
+};
+
+} // namespace std
@@ -7,6 +7,7 @@
 |----------------------------------------------------------------------------*/
 #include <algorithm>
 #include <sstream>
+#include <unordered_map>
 #include <cppy/cppy.h>
 #include <kiwi/kiwi.h>
 #include "types.h"
@@ -18,6 +19,14 @@ namespace kiwisolver
 namespace
 {
 
+// The Constraints added to solvers, see Constraint::Register. The map is
+// never destroyed, as objects can outlive the static variables.
+std::unordered_map<kiwi::Constraint, PyObject *> &registry()
+{
+    static auto *constraints = new std::unordered_map<kiwi::Constraint, PyObject *>();
+    return *constraints;
+}
+
 PyObject *
 Constraint_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
@@ -68,6 +77,9 @@ void Constraint_dealloc(Constraint *self)
 {
     PyObject_GC_UnTrack(self);
     Constraint_clear(self);
+    auto it = registry().find(self->constraint);
+    if (it != registry().end() && it->second == pyobject_cast(self))
+        registry().erase(it);
     self->constraint.~Constraint();
     Py_TYPE(self)->tp_free(pyobject_cast(self));
 }
@@ -152,6 +164,14 @@ Constraint_or(PyObject *pyoldcn, PyObject *value)
     return pynewcn;
 }
 
+PyObject *
+Constraint_reduce(Constraint *self)
+{
+    return Py_BuildValue(
+        "O(ONd)", pyobject_cast(Py_TYPE(self)), self->expression,
+        Constraint_op(self), self->constraint.strength());
+}
+
 static PyMethodDef
     Constraint_methods[] = {
         {"expression", (PyCFunction)Constraint_expression, METH_NOARGS,
@@ -160,6 +180,8 @@ static PyMethodDef
          "Get the relational operator for the constraint."},
         {"strength", (PyCFunction)Constraint_strength, METH_NOARGS,
          "Get the strength for the constraint."},
+        {"__reduce__", (PyCFunction)Constraint_reduce, METH_NOARGS,
+         "Support pickling the constraint."},
         {0} // sentinel
 };
 
@@ -191,6 +213,17 @@ PyType_Spec Constraint::TypeObject_Spec = {
     Constraint_Type_slots    /* slots */
 };
 
+void Constraint::Register(PyObject *pycn)
+{
+    registry()[reinterpret_cast<Constraint *>(pycn)->constraint] = pycn;
+}
+
+PyObject *Constraint::Lookup(const kiwi::Constraint &constraint)
+{
+    auto it = registry().find(constraint);
+    return it != registry().end() ? it->second : 0;
+}
+
 bool Constraint::Ready()
 {
     // The reference will be handled by the module to which we will add the type
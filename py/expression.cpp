@@ -188,6 +188,13 @@ Expression_richcmp( PyObject* first, PyObject* second, int op )
 }
 
 
+PyObject*
+Expression_reduce( Expression* self )
+{
+    return Py_BuildValue( "O(Od)", pyobject_cast( Py_TYPE( self ) ), self->terms, self->constant );
+}
+
+
 static PyMethodDef
 Expression_methods[] = {
     { "terms", ( PyCFunction )Expression_terms, METH_NOARGS,
@@ -196,6 +203,8 @@ Expression_methods[] = {
       "Get the constant for the expression." },
     { "value", ( PyCFunction )Expression_value, METH_NOARGS,
       "Get the value for the expression." },
+    { "__reduce__", ( PyCFunction )Expression_reduce, METH_NOARGS,
+      "Support pickling the expression." },
     { 0 } // sentinel
 };
 
@@ -42,6 +42,10 @@ bool ready_types()
     {
         return false;
     }
+    if( !ValueArray::Ready() )
+    {
+        return false;
+    }
     return true;
 }
 
@@ -122,6 +126,13 @@ bool add_objects( PyObject* mod )
 	}
     solver.release();
 
+    cppy::ptr array( pyobject_cast( ValueArray::TypeObject ) );
+	if( PyModule_AddObject( mod, "ValueArray", array.get() ) < 0 )
+	{
+		return false;
+	}
+    array.release();
+
     PyModule_AddObject( mod, "DuplicateConstraint", DuplicateConstraint );
     PyModule_AddObject( mod, "UnsatisfiableConstraint", UnsatisfiableConstraint );
     PyModule_AddObject( mod, "UnknownConstraint", UnknownConstraint );
@@ -5,6 +5,12 @@
 |
 | The full license is in the file LICENSE, distributed with this software.
 |----------------------------------------------------------------------------*/
+#include <cstdint>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 #include <cppy/cppy.h>
 #include <kiwi/kiwi.h>
 #include "types.h"
@@ -27,6 +33,7 @@ Solver_new( PyTypeObject* type, PyObject* args, PyObject* kwargs )
 		return 0;
 	Solver* self = reinterpret_cast<Solver*>( pysolver );
 	new( &self->solver ) kiwi::Solver();
+	new( &self->arrays ) std::vector<ValueArray*>();
 	return pysolver;
 }
 
@@ -34,6 +41,7 @@ Solver_new( PyTypeObject* type, PyObject* args, PyObject* kwargs )
 void
 Solver_dealloc( Solver* self )
 {
+	self->arrays.~vector();
 	self->solver.~Solver();
 	Py_TYPE( self )->tp_free( pyobject_cast( self ) );
 }
@@ -45,6 +53,7 @@ Solver_addConstraint( Solver* self, PyObject* other )
 	if( !Constraint::TypeCheck( other ) )
 		return cppy::type_error( other, "Constraint" );
 	Constraint* cn = reinterpret_cast<Constraint*>( other );
+	Constraint::Register( other );
 	try
 	{
 		self->solver.addConstraint( cn->constraint );
@@ -63,6 +72,56 @@ Solver_addConstraint( Solver* self, PyObject* other )
 }
 
 
+// Get the item of a sequence of constraints which wraps a constraint.
+PyObject*
+find_constraint( PyObject* constraints, const kiwi::Constraint& constraint )
+{
+	Py_ssize_t end = PyTuple_GET_SIZE( constraints );
+	for( Py_ssize_t i = 0; i < end; ++i )
+	{
+		PyObject* item = PyTuple_GET_ITEM( constraints, i );
+		if( reinterpret_cast<Constraint*>( item )->constraint == constraint )
+			return item;
+	}
+	return Py_None;
+}
+
+
+PyObject*
+Solver_addConstraints( Solver* self, PyObject* other )
+{
+	cppy::ptr constraints( PySequence_Tuple( other ) );
+	if( !constraints )
+		return 0;
+	Py_ssize_t end = PyTuple_GET_SIZE( constraints.get() );
+	std::vector<kiwi::Constraint> cns;
+	cns.reserve( end );
+	for( Py_ssize_t i = 0; i < end; ++i )
+	{
+		PyObject* item = PyTuple_GET_ITEM( constraints.get(), i );
+		if( !Constraint::TypeCheck( item ) )
+			return cppy::type_error( item, "Constraint" );
+		cns.push_back( reinterpret_cast<Constraint*>( item )->constraint );
+		Constraint::Register( item );
+	}
+	try
+	{
+		self->solver.addConstraints( cns.begin(), cns.end() );
+	}
+	catch( const kiwi::DuplicateConstraint& e )
+	{
+		PyErr_SetObject( DuplicateConstraint, find_constraint( constraints.get(), e.constraint() ) );
+		return 0;
+	}
+	catch( const kiwi::UnsatisfiableConstraint& e )
+	{
+		PyErr_SetObject( UnsatisfiableConstraint, find_constraint( constraints.get(), e.constraint() ) );
+		return 0;
+	}
+	Py_RETURN_NONE;
+}
+
+
 PyObject*
 Solver_removeConstraint( Solver* self, PyObject* other )
 {
@@ -82,6 +141,35 @@ Solver_removeConstraint( Solver* self, PyObject* other )
 }
 
 
+PyObject*
+Solver_removeConstraints( Solver* self, PyObject* other )
+{
+	cppy::ptr constraints( PySequence_Tuple( other ) );
+	if( !constraints )
+		return 0;
+	Py_ssize_t end = PyTuple_GET_SIZE( constraints.get() );
+	std::vector<kiwi::Constraint> cns;
+	cns.reserve( end );
+	for( Py_ssize_t i = 0; i < end; ++i )
+	{
+		PyObject* item = PyTuple_GET_ITEM( constraints.get(), i );
+		if( !Constraint::TypeCheck( item ) )
+			return cppy::type_error( item, "Constraint" );
+		cns.push_back( reinterpret_cast<Constraint*>( item )->constraint );
+	}
+	try
+	{
+		self->solver.removeConstraints( cns.begin(), cns.end() );
+	}
+	catch( const kiwi::UnknownConstraint& e )
+	{
+		PyErr_SetObject( UnknownConstraint, find_constraint( constraints.get(), e.constraint() ) );
+		return 0;
+	}
+	Py_RETURN_NONE;
+}
+
+
 PyObject*
 Solver_hasConstraint( Solver* self, PyObject* other )
 {
@@ -178,18 +266,304 @@ Solver_suggestValue( Solver* self, PyObject* args )
 }
 
 
+PyObject*
+Solver_suggestValues( Solver* self, PyObject* args )
+{
+	PyObject* pyvars;
+	PyObject* pyvalues;
+	if( !PyArg_ParseTuple( args, "OO", &pyvars, &pyvalues ) )
+		return 0;
+	cppy::ptr variables( PySequence_Tuple( pyvars ) );
+	if( !variables )
+		return 0;
+	std::vector<double> values;
+	if( !convert_to_doubles( pyvalues, values ) )
+		return 0;
+	Py_ssize_t end = PyTuple_GET_SIZE( variables.get() );
+	if( values.size() != static_cast<std::size_t>( end ) )
+		return cppy::value_error( "The number of values does not match the number of variables." );
+	std::vector<std::pair<kiwi::Variable, double>> suggestions;
+	suggestions.reserve( end );
+	for( Py_ssize_t i = 0; i < end; ++i )
+	{
+		PyObject* item = PyTuple_GET_ITEM( variables.get(), i );
+		if( !Variable::TypeCheck( item ) )
+			return cppy::type_error( item, "Variable" );
+		Variable* var = reinterpret_cast<Variable*>( item );
+		suggestions.push_back( std::make_pair( var->variable, values[ i ] ) );
+	}
+	try
+	{
+		self->solver.suggestValues( suggestions.begin(), suggestions.end() );
+	}
+	catch( const kiwi::UnknownEditVariable& e )
+	{
+		for( Py_ssize_t i = 0; i < end; ++i )
+		{
+			PyObject* item = PyTuple_GET_ITEM( variables.get(), i );
+			if( reinterpret_cast<Variable*>( item )->variable.equals( e.variable() ) )
+			{
+				PyErr_SetObject( UnknownEditVariable, item );
+				return 0;
+			}
+		}
+		PyErr_SetObject( UnknownEditVariable, Py_None );
+		return 0;
+	}
+	Py_RETURN_NONE;
+}
+
+
 PyObject*
 Solver_updateVariables( Solver* self )
 {
 	self->solver.updateVariables();
+	self->refreshArrays();
 	Py_RETURN_NONE;
 }
 
 
+PyObject*
+Solver_updateChangedVariables( Solver* self, PyObject* args )
+{
+	PyObject* pyepsilon = 0;
+	if( !PyArg_ParseTuple( args, "|O", &pyepsilon ) )
+		return 0;
+	double epsilon = 0.0;
+	if( pyepsilon && !convert_to_double( pyepsilon, epsilon ) )
+		return 0;
+	std::vector<kiwi::Variable> changed;
+	self->solver.updateChangedVariables( changed, epsilon );
+	self->refreshArrays();
+	cppy::ptr pychanged( PyList_New( 0 ) );
+	if( !pychanged )
+		return 0;
+	for( const kiwi::Variable& variable : changed )
+	{
+		// Variables whose Python object is gone cannot be observed.
+		PyObject* pyvar = Variable::Lookup( variable );
+		if( pyvar && PyList_Append( pychanged.get(), pyvar ) != 0 )
+			return 0;
+	}
+	return pychanged.release();
+}
+
+
+PyObject*
+Solver_valueArray( Solver* self, PyObject* other )
+{
+	cppy::ptr variables( PySequence_Tuple( other ) );
+	if( !variables )
+		return 0;
+	Py_ssize_t size = PyTuple_GET_SIZE( variables.get() );
+	for( Py_ssize_t i = 0; i < size; ++i )
+	{
+		PyObject* item = PyTuple_GET_ITEM( variables.get(), i );
+		if( !Variable::TypeCheck( item ) )
+			return cppy::type_error( item, "Variable" );
+	}
+	cppy::ptr pyarray( PyType_GenericAlloc( ValueArray::TypeObject, 0 ) );
+	if( !pyarray )
+		return 0;
+	ValueArray* array = reinterpret_cast<ValueArray*>( pyarray.get() );
+	array->solver = cppy::incref( pyobject_cast( self ) );
+	array->variables = variables.release();
+	new( &array->slots ) std::vector<std::size_t>( size );
+	new( &array->values ) std::vector<double>( size );
+	array->size = size;
+	array->stride = Py_ssize_t( sizeof( double ) );
+	array->addSlots();
+	array->refresh();
+	self->arrays.push_back( array );
+	return pyarray.release();
+}
+
+
 PyObject*
 Solver_reset( Solver* self )
 {
 	self->solver.reset();
+	// The slots are dropped with the rest of the solver.
+	self->resetArrays();
+	Py_RETURN_NONE;
+}
+
+
+// Make a new Constraint wrapping the same relation as a constraint whose
+// Python object is gone, over the Variables which were pickled.
+PyObject*
+rebuild_constraint( const kiwi::Constraint& constraint,
+	const std::map<kiwi::Variable, PyObject*>& pyvars )
+{
+	const kiwi::Expression& expr = constraint.expression();
+	cppy::ptr terms( PyTuple_New( Py_ssize_t( expr.terms().size() ) ) );
+	if( !terms )
+		return 0;
+	Py_ssize_t i = 0;
+	for( const kiwi::Term& term : expr.terms() )
+	{
+		auto it = pyvars.find( term.variable() );
+		if( it == pyvars.end() )
+		{
+			PyErr_SetString( PyExc_RuntimeError, "The solver holds an unknown variable." );
+			return 0;
+		}
+		PyObject* pyterm = PyObject_CallFunction(
+			pyobject_cast( Term::TypeObject ), "Od", it->second, term.coefficient() );
+		if( !pyterm )
+			return 0;
+		PyTuple_SET_ITEM( terms.get(), i++, pyterm );
+	}
+	cppy::ptr pyexpr( PyObject_CallFunction(
+		pyobject_cast( Expression::TypeObject ), "Od", terms.get(), expr.constant() ) );
+	if( !pyexpr )
+		return 0;
+	const char* op = constraint.op() == kiwi::OP_EQ ? "==" :
+		constraint.op() == kiwi::OP_LE ? "<=" : ">=";
+	return PyObject_CallFunction(
+		pyobject_cast( Constraint::TypeObject ), "Osd", pyexpr.get(), op, constraint.strength() );
+}
+
+
+// Pickle the solver as a snapshot of its state, see kiwi::Solver::save,
+// with the tuples of the Variables and the Constraints which its keys
+// index.
+PyObject*
+Solver_reduce( Solver* self )
+{
+	cppy::ptr variables( PyList_New( 0 ) );
+	cppy::ptr constraints( PyList_New( 0 ) );
+	if( !variables || !constraints )
+		return 0;
+	// The variables are saved before the constraints, which use them.
+	std::map<kiwi::Variable, PyObject*> pyvars;
+	bool failed = false;
+	std::vector<char> snapshot;
+	self->solver.save(
+		snapshot,
+		[ & ]( const kiwi::Variable& variable ) -> std::uint64_t
+		{
+			// A variable whose Python object is gone is pickled as a
+			// new Variable of the same name.
+			std::uint64_t key = std::uint64_t( PyList_GET_SIZE( variables.get() ) );
+			cppy::ptr pyvar( cppy::xincref( Variable::Lookup( variable ) ) );
+			if( !pyvar && !failed )
+				pyvar = PyObject_CallFunction(
+					pyobject_cast( Variable::TypeObject ), "s", variable.name().c_str() );
+			if( !failed && ( !pyvar || PyList_Append( variables.get(), pyvar.get() ) != 0 ) )
+				failed = true;
+			if( !failed )
+				pyvars[ variable ] = pyvar.get();
+			return key;
+		},
+		[ & ]( const kiwi::Constraint& constraint ) -> std::uint64_t
+		{
+			// A constraint whose Python object is gone is pickled as a
+			// new Constraint of the same relation.
+			std::uint64_t key = std::uint64_t( PyList_GET_SIZE( constraints.get() ) );
+			cppy::ptr pycn( cppy::xincref( Constraint::Lookup( constraint ) ) );
+			if( !pycn && !failed )
+				pycn = rebuild_constraint( constraint, pyvars );
+			if( !failed && ( !pycn || PyList_Append( constraints.get(), pycn.get() ) != 0 ) )
+				failed = true;
+			return key;
+		} );
+	if( failed )
+		return 0;
+	cppy::ptr state( Py_BuildValue(
+		"(NNN)", PyBytes_FromStringAndSize( snapshot.data(), Py_ssize_t( snapshot.size() ) ),
+		PyList_AsTuple( variables.get() ), PyList_AsTuple( constraints.get() ) ) );
+	if( !state )
+		return 0;
+	return Py_BuildValue( "O()N", pyobject_cast( Py_TYPE( self ) ), state.release() );
+}
+
+
+// Give the value arrays of a solver new slots when leaving the scope.
+struct ArraysGuard
+{
+	ArraysGuard( Solver* solver ) : m_solver( solver ) {}
+
+	~ArraysGuard()
+	{
+		m_solver->resetArrays();
+	}
+
+	Solver* m_solver;
+};
+
+
+// Restore the state pickled by Solver_reduce. The snapshot can be any
+// buffer, such as a mapped file, and is read in place.
+PyObject*
+Solver_setstate( Solver* self, PyObject* state )
+{
+	PyObject* pysnapshot;
+	PyObject* variables;
+	PyObject* constraints;
+	if( !PyArg_ParseTuple( state, "OO!O!", &pysnapshot, &PyTuple_Type, &variables,
+		&PyTuple_Type, &constraints ) )
+		return 0;
+	Py_ssize_t nvars = PyTuple_GET_SIZE( variables );
+	for( Py_ssize_t i = 0; i < nvars; ++i )
+	{
+		if( !Variable::TypeCheck( PyTuple_GET_ITEM( variables, i ) ) )
+			return cppy::type_error( PyTuple_GET_ITEM( variables, i ), "Variable" );
+	}
+	Py_ssize_t ncns = PyTuple_GET_SIZE( constraints );
+	for( Py_ssize_t i = 0; i < ncns; ++i )
+	{
+		if( !Constraint::TypeCheck( PyTuple_GET_ITEM( constraints, i ) ) )
+			return cppy::type_error( PyTuple_GET_ITEM( constraints, i ), "Constraint" );
+	}
+	Py_buffer view;
+	if( PyObject_GetBuffer( pysnapshot, &view, PyBUF_SIMPLE ) != 0 )
+		return 0;
+	// Loading resets the solver, which drops the slots of the value arrays
+	// even when the snapshot is rejected.
+	ArraysGuard guard( self );
+	try
+	{
+		self->solver.load(
+			static_cast<const char*>( view.buf ), std::size_t( view.len ),
+			[ & ]( std::uint64_t key ) -> kiwi::Variable
+			{
+				if( key >= std::uint64_t( nvars ) )
+					throw kiwi::BadSnapshot( "The snapshot has an unknown variable." );
+				return reinterpret_cast<Variable*>( PyTuple_GET_ITEM( variables, key ) )->variable;
+			},
+			[ & ]( std::uint64_t key ) -> kiwi::Constraint
+			{
+				if( key >= std::uint64_t( ncns ) )
+					throw kiwi::BadSnapshot( "The snapshot has an unknown constraint." );
+				return reinterpret_cast<Constraint*>( PyTuple_GET_ITEM( constraints, key ) )->constraint;
+			} );
+	}
+	catch( const kiwi::BadSnapshot& e )
+	{
+		PyBuffer_Release( &view );
+		PyErr_SetString( PyExc_ValueError, e.what() );
+		return 0;
+	}
+	catch( const std::bad_alloc& )
+	{
+		PyBuffer_Release( &view );
+		PyErr_NoMemory();
+		return 0;
+	}
+	catch( const std::exception& e )
+	{
+		PyBuffer_Release( &view );
+		PyErr_SetString( PyExc_ValueError, e.what() );
+		return 0;
+	}
+	PyBuffer_Release( &view );
+	for( Py_ssize_t i = 0; i < ncns; ++i )
+	{
+		PyObject* item = PyTuple_GET_ITEM( constraints, i );
+		if( self->solver.hasConstraint( reinterpret_cast<Constraint*>( item )->constraint ) )
+			Constraint::Register( item );
+	}
 	Py_RETURN_NONE;
 }
 
@@ -212,8 +586,12 @@ static PyMethodDef
 Solver_methods[] = {
 	{ "addConstraint", ( PyCFunction )Solver_addConstraint, METH_O,
 	  "Add a constraint to the solver." },
+	{ "addConstraints", ( PyCFunction )Solver_addConstraints, METH_O,
+	  "Add an iterable of constraints to the solver and optimize once." },
 	{ "removeConstraint", ( PyCFunction )Solver_removeConstraint, METH_O,
 	  "Remove a constraint from the solver." },
+	{ "removeConstraints", ( PyCFunction )Solver_removeConstraints, METH_O,
+	  "Remove an iterable of constraints from the solver and optimize once." },
 	{ "hasConstraint", ( PyCFunction )Solver_hasConstraint, METH_O,
 	  "Check whether the solver contains a constraint." },
 	{ "addEditVariable", ( PyCFunction )Solver_addEditVariable, METH_VARARGS,
@@ -224,10 +602,20 @@ Solver_methods[] = {
 	  "Check whether the solver contains an edit variable." },
 	{ "suggestValue", ( PyCFunction )Solver_suggestValue, METH_VARARGS,
 	  "Suggest a desired value for an edit variable." },
+	{ "suggestValues", ( PyCFunction )Solver_suggestValues, METH_VARARGS,
+	  "Suggest values for a sequence of edit variables and optimize once." },
 	{ "updateVariables", ( PyCFunction )Solver_updateVariables, METH_NOARGS,
 	  "Update the values of the solver variables." },
+	{ "updateChangedVariables", ( PyCFunction )Solver_updateChangedVariables, METH_VARARGS,
+	  "Update the variables changed since the last update and return those which moved by more than epsilon." },
+	{ "valueArray", ( PyCFunction )Solver_valueArray, METH_O,
+	  "Get a read-only buffer of the values of variables refreshed on each update." },
 	{ "reset", ( PyCFunction )Solver_reset, METH_NOARGS,
 	  "Reset the solver to the initial empty starting condition." },
+	{ "__reduce__", ( PyCFunction )Solver_reduce, METH_NOARGS,
+	  "Pickle the solver as a snapshot of its state." },
+	{ "__setstate__", ( PyCFunction )Solver_setstate, METH_O,
+	  "Restore the solver from a pickled snapshot of its state." },
 	{ "dump", ( PyCFunction )Solver_dump, METH_NOARGS,
 	  "Dump a representation of the solver internals to stdout." },
 	{ "dumps", ( PyCFunction )Solver_dumps, METH_NOARGS,
@@ -249,6 +637,23 @@ static PyType_Slot Solver_Type_slots[] = {
 } // namespace
 
 
+void Solver::refreshArrays()
+{
+	for( ValueArray* array : arrays )
+		array->refresh();
+}
+
+
+void Solver::resetArrays()
+{
+	for( ValueArray* array : arrays )
+	{
+		array->addSlots();
+		array->refresh();
+	}
+}
+
+
 // Initialize static variables (otherwise the compiler eliminates them)
 PyTypeObject* Solver::TypeObject = NULL;
 
@@ -166,6 +166,13 @@ Term_richcmp( PyObject* first, PyObject* second, int op )
 }
 
 
+PyObject*
+Term_reduce( Term* self )
+{
+	return Py_BuildValue( "O(Od)", pyobject_cast( Py_TYPE( self ) ), self->variable, self->coefficient );
+}
+
+
 static PyMethodDef
 Term_methods[] = {
 	{ "variable", ( PyCFunction )Term_variable, METH_NOARGS,
@@ -174,6 +181,8 @@ Term_methods[] = {
 	  "Get the coefficient for the term." },
 	{ "value", ( PyCFunction )Term_value, METH_NOARGS,
 	  "Get the value for the term." },
+	{ "__reduce__", ( PyCFunction )Term_reduce, METH_NOARGS,
+	  "Support pickling the term." },
 	{ 0 } // sentinel
 };
 
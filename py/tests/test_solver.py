@@ -5,6 +5,10 @@
 #
 # The full license is in the file LICENSE, distributed with this software.
 #------------------------------------------------------------------------------
+from array import array
+import pickle
+import sys
+
 import pytest
 
 from kiwisolver import (Solver, Variable,
@@ -92,6 +96,133 @@ def test_suggesting_values_for_edit_variables():
     assert v2.value() <= -1
 
 
+def test_suggesting_values_in_batch():
+    """Test suggesting values for several edit variables at once.
+
+    """
+    s = Solver()
+    x = Variable('x')
+    y = Variable('y')
+    w = Variable('w')
+    s.addConstraint(w >= 0)
+    for v in (x, y, w):
+        s.addEditVariable(v, 'strong')
+
+    with pytest.raises(TypeError):
+        s.suggestValues([x, object()], [1, 2])
+    with pytest.raises(TypeError):
+        s.suggestValues([x, y], [1, 'a'])
+    with pytest.raises(ValueError):
+        s.suggestValues([x, y], [1, 2, 3])
+
+    s.suggestValues([x, y, w], [1, 2.5, 3])
+    s.updateVariables()
+    assert (x.value(), y.value(), w.value()) == (1, 2.5, 3)
+
+    # Buffers of doubles and floats are read directly, other buffers are
+    # read as sequences.
+    s.suggestValues((x, y, w), array('d', [4, 5, -6]))
+    s.updateVariables()
+    assert (x.value(), y.value(), w.value()) == (4, 5, 0)
+    s.suggestValues(iter([x, y]), array('f', [7.5, 8]))
+    s.suggestValues([w], array('i', [9]))
+    s.updateVariables()
+    assert (x.value(), y.value(), w.value()) == (7.5, 8, 9)
+
+    # The suggestions which precede an unknown edit variable are kept.
+    z = Variable('z')
+    with pytest.raises(UnknownEditVariable) as excinfo:
+        s.suggestValues([x, z, y], [10, 11, 12])
+    assert excinfo.value.args[0] is z
+    s.updateVariables()
+    assert (x.value(), y.value()) == (10, 8)
+
+
+def test_updating_changed_variables():
+    """Test updating only the variables which changed.
+
+    """
+    def names(variables):
+        return sorted(v.name() for v in variables)
+
+    s = Solver()
+    x = Variable('x')
+    y = Variable('y')
+    w = Variable('w')
+    s.addConstraint(y == x + 10)
+    s.addConstraint(w >= 0)
+    s.addEditVariable(x, 'strong')
+    s.addEditVariable(w, 'strong')
+
+    s.suggestValue(x, 5)
+    assert names(s.updateChangedVariables()) == ['x', 'y']
+    assert (x.value(), y.value(), w.value()) == (5, 15, 0)
+    assert s.updateChangedVariables() == []
+
+    s.suggestValue(w, 3)
+    changed = s.updateChangedVariables()
+    assert len(changed) == 1 and changed[0] is w
+    assert w.value() == 3
+
+    # Changes smaller than epsilon are not written.
+    s.suggestValue(x, 5.5)
+    assert s.updateChangedVariables(1) == []
+    assert x.value() == 5
+    s.suggestValue(x, 7)
+    assert names(s.updateChangedVariables(1.0)) == ['x', 'y']
+    assert (x.value(), y.value()) == (7, 17)
+
+    with pytest.raises(TypeError):
+        s.updateChangedVariables('a')
+
+    # Variables which are gone are not returned.
+    z = Variable('z')
+    s.addConstraint(z == 10)
+    del z
+    assert s.updateChangedVariables() == []
+
+
+def test_value_array():
+    """Test reading the values of variables through a buffer.
+
+    """
+    s = Solver()
+    x = Variable('x')
+    y = Variable('y')
+    z = Variable('z')
+    s.addConstraint(y == x + 10)
+    s.addEditVariable(x, 'strong')
+
+    with pytest.raises(TypeError):
+        s.valueArray([x, object()])
+
+    values = s.valueArray([x, y, z])
+    assert len(values) == 3
+    view = memoryview(values)
+    assert view.format == 'd' and view.readonly and view.shape == (3,)
+    assert view.strides == (view.itemsize,)
+    assert view.tolist() == [0, 10, 0]
+
+    # The values are refreshed by the updates of the solver.
+    s.suggestValue(x, 5)
+    assert view.tolist() == [0, 10, 0]
+    s.updateVariables()
+    assert view.tolist() == [5, 15, 0]
+    s.suggestValue(x, 7)
+    s.updateChangedVariables()
+    assert view.tolist() == [7, 17, 0]
+
+    # The array survives a reset of the solver.
+    s.reset()
+    s.addConstraint(z == 3)
+    s.updateVariables()
+    assert view.tolist() == [0, 0, 3]
+
+    with pytest.raises(TypeError):
+        memoryview(values)[0] = 1
+    del view, values
+
+
 def test_managing_constraints():
     """Test adding/removing constraints.
 
@@ -131,6 +262,204 @@ def test_managing_constraints():
     assert not s.hasConstraint(c2)
 
 
+def test_adding_constraints_in_batch():
+    """Test adding several constraints at once.
+
+    """
+    s = Solver()
+    v1 = Variable('foo')
+    v2 = Variable('bar')
+    c1 = v1 >= 1
+    c2 = v2 == v1 + 10
+    c3 = (v1 == 40) | 'weak'
+
+    with pytest.raises(TypeError):
+        s.addConstraints(object())
+    with pytest.raises(TypeError):
+        s.addConstraints([c1, object()])
+    assert not s.hasConstraint(c1)
+
+    s.addConstraints(iter([c1, c2, c3]))
+    assert all(s.hasConstraint(c) for c in (c1, c2, c3))
+    s.updateVariables()
+    assert v1.value() == 40
+    assert v2.value() == 50
+
+    # The constraints before the failing one remain in the solver.
+    c4 = v2 <= 100
+    c5 = v1 <= 0
+    c6 = v2 >= 0
+    with pytest.raises(UnsatisfiableConstraint) as excinfo:
+        s.addConstraints([c4, c5, c6])
+    assert excinfo.value.args[0] is c5
+    assert s.hasConstraint(c4)
+    assert not s.hasConstraint(c5)
+    assert not s.hasConstraint(c6)
+
+    with pytest.raises(DuplicateConstraint) as excinfo:
+        s.addConstraints([c6, c1])
+    assert excinfo.value.args[0] is c1
+    assert s.hasConstraint(c6)
+
+
+def test_removing_constraints_in_batch():
+    """Test removing several constraints at once.
+
+    """
+    s = Solver()
+    v1 = Variable('foo')
+    v2 = Variable('bar')
+    c1 = v1 >= 1
+    c2 = v2 == v1 + 10
+    c3 = (v1 == 40) | 'weak'
+    c4 = (v1 == 20) | 'medium'
+    s.addConstraints([c1, c2, c3, c4])
+
+    with pytest.raises(TypeError):
+        s.removeConstraints(object())
+    with pytest.raises(TypeError):
+        s.removeConstraints([c1, object()])
+
+    # An unknown constraint leaves the solver untouched.
+    c5 = v2 <= 100
+    with pytest.raises(UnknownConstraint) as excinfo:
+        s.removeConstraints([c4, c5])
+    assert excinfo.value.args[0] is c5
+    assert s.hasConstraint(c4)
+    with pytest.raises(UnknownConstraint):
+        s.removeConstraints([c4, c4])
+    assert s.hasConstraint(c4)
+
+    s.removeConstraints(iter([c2, c4]))
+    assert not s.hasConstraint(c2)
+    assert not s.hasConstraint(c4)
+    assert s.hasConstraint(c1)
+    assert s.hasConstraint(c3)
+    s.updateVariables()
+    assert v1.value() == 40
+
+    s.removeConstraints([c1, c3])
+    s.addConstraints([c1, c2, c3, c4])
+    s.updateVariables()
+    assert v1.value() == 20
+    assert v2.value() == 30
+
+
+def test_churning_constraints_in_batch():
+    """Test that adding and removing batches reuses the symbol ids.
+
+    """
+    s = Solver()
+    v1 = Variable('foo')
+    v2 = Variable('bar')
+    cns = [v1 >= 10, (v2 == v1 + 5) | 'strong']
+    s.addConstraints(cns)
+    size = len(s.__reduce__()[2][0])
+    for _ in range(1000):
+        s.removeConstraints(cns)
+        s.addConstraints(cns)
+    assert len(s.__reduce__()[2][0]) == size
+
+
+def test_pickling_solver():
+    """Test restoring a solver from a pickled snapshot of its state.
+
+    """
+    x = Variable('x')
+    y = Variable('y')
+    w = Variable('w')
+    s = Solver()
+    c1 = y == x + 10
+    c2 = (y <= 50) | 'strong'
+    s.addConstraints([c1, c2, w >= 0])
+    s.addEditVariable(x, 'medium')
+    s.suggestValue(x, 45)
+
+    s2, x2, y2, c12, c22 = pickle.loads(pickle.dumps((s, x, y, c1, c2)))
+    assert x2.name() == 'x'
+    assert s2.hasConstraint(c12) and s2.hasConstraint(c22)
+    assert s2.hasEditVariable(x2)
+    s2.updateVariables()
+    assert (x2.value(), y2.value()) == (40, 50)
+
+    # The restored solver is ready for new suggestions.
+    s2.suggestValue(x2, 20)
+    s2.updateVariables()
+    assert (x2.value(), y2.value()) == (20, 30)
+    s2.removeConstraint(c22)
+    s2.suggestValue(x2, 45)
+    s2.updateVariables()
+    assert y2.value() == 55
+
+    # The original solver is unchanged.
+    s.updateVariables()
+    assert (x.value(), y.value()) == (40, 50)
+
+    snapshot, variables, constraints = s.__reduce__()[2]
+    with pytest.raises(ValueError):
+        s2.__setstate__((snapshot[:-8], variables, constraints))
+    with pytest.raises(ValueError):
+        s2.__setstate__((snapshot, variables, constraints[:1]))
+    with pytest.raises(TypeError):
+        s2.__setstate__((snapshot, constraints, variables))
+    assert not s2.hasEditVariable(x2)
+
+
+def test_restoring_corrupt_state_keeps_value_arrays():
+    """Test that a rejected state leaves the value arrays of a solver valid.
+
+    """
+    x = Variable('x')
+    y = Variable('y')
+    s = Solver()
+    s.addConstraint(y == x + 10)
+    s.addConstraint((x == 5) | 'weak')
+    old = s.valueArray([x, y])
+    s.updateVariables()
+    assert memoryview(old).tolist() == [5, 15]
+
+    snapshot, variables, constraints = s.__reduce__()[2]
+    with pytest.raises(ValueError):
+        s.__setstate__((snapshot[:-8], variables, constraints))
+
+    # The solver is empty and both arrays have slots of their own.
+    new = s.valueArray([y, x])
+    s.addConstraint(x == 42)
+    s.updateVariables()
+    assert memoryview(old).tolist() == [42, 0]
+    assert memoryview(new).tolist() == [0, 42]
+    del old
+    s.updateVariables()
+    assert memoryview(new).tolist() == [0, 42]
+
+
+def test_pickling_solver_with_dropped_constraints():
+    """Test pickling a solver whose constraint objects are gone.
+
+    """
+    x = Variable('x')
+    y = Variable('y')
+    s = Solver()
+    c = (y == 2 * x + 10) | 'strong'
+    refs = sys.getrefcount(c)
+    s.addConstraint(c)
+    s.addConstraints([x == 5])
+    assert sys.getrefcount(c) == refs
+
+    s2, x2, y2 = pickle.loads(pickle.dumps((s, x, y)))
+    s2.updateVariables()
+    assert (x2.value(), y2.value()) == (5, 20)
+
+    # The live constraint is pickled as is and the other one is rebuilt.
+    snapshot, variables, constraints = s.__reduce__()[2]
+    assert len(constraints) == 2
+    assert any(cn is c for cn in constraints)
+    s3 = Solver()
+    s3.__setstate__((snapshot, variables, constraints))
+    for cn in constraints:
+        s3.removeConstraint(cn)
+
+
 def test_solving_under_constrained_system():
     """Test solving an under constrained system.
 
@@ -6,6 +6,7 @@
 | The full license is in the file LICENSE, distributed with this software.
 |----------------------------------------------------------------------------*/
 #pragma once
+#include <vector>
 #include <Python.h>
 #include <kiwi/kiwi.h>
 
@@ -44,6 +45,23 @@ struct Variable
 	PyObject* context;
 	kiwi::Variable variable;
 
+	// The context of the wrapped kiwi variable, which points back to the
+	// Python object so that the solver can return it. The pointer is
+	// borrowed and the context is dropped when the object is deallocated.
+	struct Owner : public kiwi::Variable::Context
+	{
+		Owner( PyObject* owner ) : owner( owner ) {}
+		PyObject* owner;
+	};
+
+	// Get the Python object wrapping a kiwi variable, or null if it is
+	// gone or was not created from Python.
+	static PyObject* Lookup( const kiwi::Variable& variable )
+	{
+		Owner* owner = static_cast<Owner*>( variable.context() );
+		return owner ? owner->owner : 0;
+	}
+
     static PyType_Spec TypeObject_Spec;
 
     static PyTypeObject* TypeObject;
@@ -101,6 +119,15 @@ struct Constraint
 	PyObject* expression;
 	kiwi::Constraint constraint;
 
+	// Remember the object wrapping a constraint added to a solver, so that
+	// pickling the solver keeps the identity of its constraints. The object
+	// is borrowed and it is forgotten when it is deallocated.
+	static void Register( PyObject* pycn );
+
+	// Get the Constraint wrapping a kiwi constraint, or null if it is gone
+	// or was never added to a solver.
+	static PyObject* Lookup( const kiwi::Constraint& constraint );
+
     static PyType_Spec TypeObject_Spec;
 
     static PyTypeObject* TypeObject;
@@ -114,10 +141,14 @@ struct Constraint
 };
 
 
+struct ValueArray;
+
+
 struct Solver
 {
 	PyObject_HEAD
 	kiwi::Solver solver;
+	std::vector<ValueArray*> arrays;  // borrowed, refreshed on update
 
     static PyType_Spec TypeObject_Spec;
 
@@ -129,6 +160,44 @@ struct Solver
 	{
 		return PyObject_TypeCheck( obj, TypeObject ) != 0;
 	}
+
+	// Copy the values of the solver to its value arrays.
+	void refreshArrays();
+
+	// Give the value arrays new slots once the solver dropped them.
+	void resetArrays();
+};
+
+
+// A read-only buffer of the values of a sequence of variables, which the
+// solver refreshes each time it updates its variables. The values are
+// copied from the value slots of the solver.
+struct ValueArray
+{
+	PyObject_HEAD
+	PyObject* solver;     // the Solver which refreshes the array
+	PyObject* variables;  // a tuple of the Variables of the array
+	std::vector<std::size_t> slots;
+	std::vector<double> values;
+	Py_ssize_t size;
+	Py_ssize_t stride;    // the stride of the buffer, owned by the array
+
+    static PyType_Spec TypeObject_Spec;
+
+    static PyTypeObject* TypeObject;
+
+	static bool Ready();
+
+	static bool TypeCheck( PyObject* obj )
+	{
+		return PyObject_TypeCheck( obj, TypeObject ) != 0;
+	}
+
+	// Give the variables value slots in the solver.
+	void addSlots();
+
+	// Copy the values of the slots to the array.
+	void refresh();
 };
 
 
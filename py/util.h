@@ -6,8 +6,10 @@
 | The full license is in the file LICENSE, distributed with this software.
 |----------------------------------------------------------------------------*/
 #pragma once
+#include <algorithm>
 #include <map>
 #include <string>
+#include <vector>
 #include <cppy/cppy.h>
 #include <kiwi/kiwi.h>
 #include "types.h"
@@ -36,6 +38,57 @@ convert_to_double( PyObject* obj, double& out )
 }
 
 
+// Convert a buffer of floats or doubles, or any sequence of numbers, to a
+// vector of doubles. The buffer is read directly, without creating an
+// object per item.
+inline bool
+convert_to_doubles( PyObject* obj, std::vector<double>& out )
+{
+    Py_buffer view;
+    if( PyObject_CheckBuffer( obj ) &&
+        PyObject_GetBuffer( obj, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT ) == 0 )
+    {
+        const char* format = view.format ? view.format : "B";
+        if( *format == '@' || *format == '=' )
+            ++format;
+        bool dbl = format[0] == 'd' && format[1] == '\0' && view.itemsize == sizeof( double );
+        bool flt = format[0] == 'f' && format[1] == '\0' && view.itemsize == sizeof( float );
+        if( view.ndim <= 1 && ( dbl || flt ) )
+        {
+            Py_ssize_t count = view.len / view.itemsize;
+            out.resize( count );
+            if( dbl )
+            {
+                const double* data = static_cast<const double*>( view.buf );
+                std::copy( data, data + count, out.begin() );
+            }
+            else
+            {
+                const float* data = static_cast<const float*>( view.buf );
+                std::copy( data, data + count, out.begin() );
+            }
+            PyBuffer_Release( &view );
+            return true;
+        }
+        PyBuffer_Release( &view );
+    }
+    // Other buffers, for instance of integers or strided, are read as
+    // sequences.
+    PyErr_Clear();
+    cppy::ptr items( PySequence_Tuple( obj ) );
+    if( !items )
+        return false;
+    Py_ssize_t end = PyTuple_GET_SIZE( items.get() );
+    out.resize( end );
+    for( Py_ssize_t i = 0; i < end; ++i )
+    {
+        if( !convert_to_double( PyTuple_GET_ITEM( items.get(), i ), out[ i ] ) )
+            return false;
+    }
+    return true;
+}
+
+
 inline bool
 convert_pystr_to_str( PyObject* value, std::string& out )
 {
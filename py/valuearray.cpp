@@ -0,0 +1,134 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#include <algorithm>
+#include <cppy/cppy.h>
+#include <kiwi/kiwi.h>
+#include "types.h"
+#include "util.h"
+
+
+namespace kiwisolver
+{
+
+
+namespace
+{
+
+
+PyObject*
+ValueArray_new( PyTypeObject* type, PyObject* args, PyObject* kwargs )
+{
+	return cppy::type_error( "ValueArray instances are created by Solver.valueArray" );
+}
+
+
+void
+ValueArray_dealloc( ValueArray* self )
+{
+	Solver* solver = reinterpret_cast<Solver*>( self->solver );
+	std::vector<ValueArray*>& arrays = solver->arrays;
+	arrays.erase( std::remove( arrays.begin(), arrays.end(), self ), arrays.end() );
+	for( std::size_t slot : self->slots )
+		solver->solver.removeValueSlot( slot );
+	self->slots.~vector();
+	self->values.~vector();
+	Py_CLEAR( self->solver );
+	Py_CLEAR( self->variables );
+	Py_TYPE( self )->tp_free( pyobject_cast( self ) );
+}
+
+
+Py_ssize_t
+ValueArray_length( ValueArray* self )
+{
+	return self->size;
+}
+
+
+int
+ValueArray_getbuffer( ValueArray* self, Py_buffer* view, int flags )
+{
+	if( flags & PyBUF_WRITABLE )
+	{
+		PyErr_SetString( PyExc_BufferError, "ValueArray is read-only." );
+		view->obj = 0;
+		return -1;
+	}
+	view->obj = cppy::incref( pyobject_cast( self ) );
+	view->buf = self->values.data();
+	view->len = self->size * Py_ssize_t( sizeof( double ) );
+	view->readonly = 1;
+	view->itemsize = sizeof( double );
+	view->format = ( flags & PyBUF_FORMAT ) ? const_cast<char*>( "d" ) : 0;
+	view->ndim = 1;
+	view->shape = ( flags & PyBUF_ND ) == PyBUF_ND ? &self->size : 0;
+	view->strides = ( flags & PyBUF_STRIDES ) == PyBUF_STRIDES ? &self->stride : 0;
+	view->suboffsets = 0;
+	view->internal = 0;
+	return 0;
+}
+
+
+static PyType_Slot ValueArray_Type_slots[] = {
+    { Py_tp_dealloc, void_cast( ValueArray_dealloc ) },      /* tp_dealloc */
+    { Py_tp_new, void_cast( ValueArray_new ) },              /* tp_new */
+    { Py_tp_alloc, void_cast( PyType_GenericAlloc ) },       /* tp_alloc */
+    { Py_tp_free, void_cast( PyObject_Del ) },               /* tp_free */
+    { Py_sq_length, void_cast( ValueArray_length ) },        /* sq_length */
+    { Py_bf_getbuffer, void_cast( ValueArray_getbuffer ) },  /* bf_getbuffer */
+    { 0, 0 },
+};
+
+
+} // namespace
+
+
+void ValueArray::addSlots()
+{
+	kiwi::Solver& solver = reinterpret_cast<Solver*>( this->solver )->solver;
+	for( Py_ssize_t i = 0; i < size; ++i )
+	{
+		PyObject* item = PyTuple_GET_ITEM( variables, i );
+		slots[ i ] = solver.addValueSlot( reinterpret_cast<Variable*>( item )->variable );
+	}
+}
+
+
+void ValueArray::refresh()
+{
+	const double* slotted = reinterpret_cast<Solver*>( solver )->solver.valueSlots();
+	for( Py_ssize_t i = 0; i < size; ++i )
+		values[ i ] = slotted[ slots[ i ] ];
+}
+
+
+// Initialize static variables (otherwise the compiler eliminates them)
+PyTypeObject* ValueArray::TypeObject = NULL;
+
+
+PyType_Spec ValueArray::TypeObject_Spec = {
+	"kiwisolver.ValueArray",             /* tp_name */
+	sizeof( ValueArray ),                /* tp_basicsize */
+	0,                                   /* tp_itemsize */
+	Py_TPFLAGS_DEFAULT,                  /* tp_flags */
+	ValueArray_Type_slots                /* slots */
+};
+
+
+bool ValueArray::Ready()
+{
+	// The reference will be handled by the module to which we will add the type
+	TypeObject = pytype_cast( PyType_FromSpec( &TypeObject_Spec ) );
+	if( !TypeObject )
+	{
+		return false;
+	}
+	return true;
+}
+
+}  // namespace kiwisolver
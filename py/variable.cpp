@@ -5,6 +5,7 @@
 |
 | The full license is in the file LICENSE, distributed with this software.
 |----------------------------------------------------------------------------*/
+#include <stdexcept>
 #include <cppy/cppy.h>
 #include <kiwi/kiwi.h>
 #include "symbolics.h"
@@ -32,27 +33,23 @@ Variable_new( PyTypeObject* type, PyObject* args, PyObject* kwargs )
 		&name, &context ) )
 		return 0;
 
-	cppy::ptr pyvar( PyType_GenericNew( type, args, kwargs ) );
-	if( !pyvar )
-		return 0;
-
-	Variable* self = reinterpret_cast<Variable*>( pyvar.get() );
-	self->context = cppy::xincref( context );
-
+	std::string c_name;
 	if( name != 0 )
 	{
 		if( !PyUnicode_Check( name ) )
 			return cppy::type_error( name, "str" );
-		std::string c_name;
 		if( !convert_pystr_to_str(name, c_name) )
 			return 0;  // LCOV_EXCL_LINE
-		new( &self->variable ) kiwi::Variable( c_name );
-	}
-	else
-	{
-		new( &self->variable ) kiwi::Variable();
 	}
 
+	cppy::ptr pyvar( PyType_GenericNew( type, args, kwargs ) );
+	if( !pyvar )
+		return 0;
+
+	Variable* self = reinterpret_cast<Variable*>( pyvar.get() );
+	self->context = cppy::xincref( context );
+	new( &self->variable ) kiwi::Variable( c_name, new Variable::Owner( pyvar.get() ) );
+
 	return pyvar.release();
 }
 
@@ -81,6 +78,8 @@ Variable_dealloc( Variable* self )
 {
 	PyObject_GC_UnTrack( self );
 	Variable_clear( self );
+	// Solvers can outlive the object, forget it before it goes away.
+	self->variable.setContext( 0 );
 	self->variable.~Variable();
 	Py_TYPE( self )->tp_free( pyobject_cast( self ) );
 }
@@ -138,7 +137,16 @@ Variable_setContext( Variable* self, PyObject* value )
 PyObject*
 Variable_value( Variable* self )
 {
-	return PyFloat_FromDouble( self->variable.value() );
+	// A variable pulling its value from a solver can run its optimization.
+	try
+	{
+		return PyFloat_FromDouble( self->variable.value() );
+	}
+	catch( const std::exception& e )
+	{
+		PyErr_SetString( PyExc_RuntimeError, e.what() );
+		return 0;
+	}
 }
 
 
@@ -203,6 +211,17 @@ Variable_richcmp( PyObject* first, PyObject* second, int op )
 }
 
 
+// The value of a variable is not pickled, it is set by a solver.
+PyObject*
+Variable_reduce( Variable* self )
+{
+	const char* name = self->variable.name().c_str();
+	if( self->context )
+		return Py_BuildValue( "O(sO)", pyobject_cast( Py_TYPE( self ) ), name, self->context );
+	return Py_BuildValue( "O(s)", pyobject_cast( Py_TYPE( self ) ), name );
+}
+
+
 static PyMethodDef
 Variable_methods[] = {
 	{ "name", ( PyCFunction )Variable_name, METH_NOARGS,
@@ -215,6 +234,8 @@ Variable_methods[] = {
 	  "Set the context object associated with the variable." },
 	{ "value", ( PyCFunction )Variable_value, METH_NOARGS,
 	  "Get the current value of the variable." },
+	{ "__reduce__", ( PyCFunction )Variable_reduce, METH_NOARGS,
+	  "Support pickling the variable." },
 	{ 0 } // sentinel
 };
 
@@ -27,6 +27,7 @@ ext_modules = [
          'py/solver.cpp',
          'py/strength.cpp',
          'py/term.cpp',
+         'py/valuearray.cpp',
          'py/variable.cpp'],
         include_dirs=['.'],
         language='c++',
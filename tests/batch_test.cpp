@@ -0,0 +1,225 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Check the batch operations, serially and on an executor.
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <kiwi/kiwi.h>
+#include "check.h"
+
+using namespace kiwi;
+
+// A small form whose constraints are independent of those of other forms.
+struct Form
+{
+    Form()
+    {
+        constraints.push_back(left >= 0);
+        constraints.push_back(top >= 0);
+        constraints.push_back(right == left + width);
+        constraints.push_back(bottom == top + height);
+        constraints.push_back(label == (left + right) / 2);
+        constraints.push_back((label >= left + 10) | strength::strong);
+        constraints.push_back((right <= 500) | strength::medium);
+        constraints.push_back((width >= 100) | strength::strong);
+        constraints.push_back((top == 0) | strength::weak);
+    }
+
+    Variable left, top, right, bottom, width, height, label;
+    std::vector<Constraint> constraints;
+};
+
+std::uint64_t id_tick(Solver &solver)
+{
+    std::vector<char> buffer;
+    solver.save(buffer, [](const Variable &) { return 0; }, [](const Constraint &) { return 0; });
+    impl::SnapshotHeader header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    return header.idTick;
+}
+
+// The lines of a dump, sorted as the maps of the solver are unordered.
+std::vector<std::string> dump_lines(Solver &solver)
+{
+    std::istringstream stream(solver.dumps());
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(stream, line);)
+        lines.push_back(line);
+    std::sort(lines.begin(), lines.end());
+    return lines;
+}
+
+void check_same_values(const std::vector<Form> &forms, Solver &serial, Solver &parallel)
+{
+    std::vector<Variable> vars;
+    for (const Form &form : forms)
+        vars.insert(vars.end(), {form.left, form.top, form.right, form.bottom, form.width, form.height, form.label});
+    std::vector<double> serialValues(vars.size());
+    std::vector<double> parallelValues(vars.size());
+    serial.exportValues(vars.begin(), vars.end(), serialValues.data());
+    parallel.exportValues(vars.begin(), vars.end(), parallelValues.data());
+    CHECK(serialValues == parallelValues);
+    CHECK(dump_lines(serial) == dump_lines(parallel));
+}
+
+void test_batches_reuse_ids()
+{
+    Variable x("x");
+    Variable y("y");
+    std::vector<Constraint> constraints = {x >= 10, (y == x + 5) | strength::strong};
+    Solver solver;
+    solver.addConstraints(constraints.begin(), constraints.end());
+    std::uint64_t tick = id_tick(solver);
+    for (int i = 0; i < 1000; ++i)
+    {
+        solver.removeConstraints(constraints.begin(), constraints.end());
+        solver.addConstraints(constraints.begin(), constraints.end());
+    }
+    CHECK(id_tick(solver) == tick);
+}
+
+void test_batches_on_executor_keep_ids_bounded()
+{
+    std::vector<Form> forms(4);
+    std::vector<Constraint> constraints;
+    for (const Form &form : forms)
+        constraints.insert(constraints.end(), form.constraints.begin(), form.constraints.end());
+    WorkStealingPool pool(4);
+    Solver solver;
+    solver.setExecutor(&pool);
+    solver.addConstraints(constraints.begin(), constraints.end());
+    std::uint64_t tick = id_tick(solver);
+    for (int i = 0; i < 1000; ++i)
+    {
+        solver.removeConstraints(constraints.begin(), constraints.end());
+        solver.addConstraints(constraints.begin(), constraints.end());
+    }
+    CHECK(id_tick(solver) <= 2 * tick);
+}
+
+void test_executor_matches_serial_solver()
+{
+    std::vector<Form> forms(12);
+    std::vector<Constraint> constraints;
+    for (const Form &form : forms)
+        constraints.insert(constraints.end(), form.constraints.begin(), form.constraints.end());
+
+    WorkStealingPool pool(4);
+    Solver serial;
+    Solver parallel;
+    parallel.setExecutor(&pool);
+    for (Solver *solver : {&serial, &parallel})
+    {
+        for (const Form &form : forms)
+        {
+            solver->addEditVariable(form.width, strength::strong);
+            solver->addEditVariable(form.height, strength::strong);
+        }
+        solver->addConstraints(constraints.begin(), constraints.end());
+    }
+    CHECK(parallel.componentCount() == serial.componentCount());
+    check_same_values(forms, serial, parallel);
+
+    // Suggesting values for every form dual optimizes the forms apart.
+    for (int step = 0; step < 10; ++step)
+    {
+        std::vector<std::pair<Variable, double>> suggestions;
+        for (std::size_t i = 0; i < forms.size(); ++i)
+        {
+            suggestions.emplace_back(forms[i].width, 50.0 + 60.0 * double((i + step) % 8));
+            suggestions.emplace_back(forms[i].height, 20.0 * double(step + i));
+        }
+        serial.suggestValues(suggestions.begin(), suggestions.end());
+        parallel.suggestValues(suggestions.begin(), suggestions.end());
+        check_same_values(forms, serial, parallel);
+    }
+
+    // A failing batch leaves both solvers with the constraints before it.
+    std::vector<Constraint> failing = {forms[0].left >= 1000, forms[1].left <= -1};
+    CHECK_THROWS(serial.addConstraints(failing.begin(), failing.end()), UnsatisfiableConstraint);
+    CHECK_THROWS(parallel.addConstraints(failing.begin(), failing.end()), UnsatisfiableConstraint);
+    CHECK(parallel.hasConstraint(failing[0]) && serial.hasConstraint(failing[0]));
+
+    // The serial solver reused the id released by the failed constraint
+    // where the executor drew a fresh one, which compacting undoes.
+    serial.compact();
+    parallel.compact();
+    check_same_values(forms, serial, parallel);
+}
+
+void test_executor_after_removals()
+{
+    std::vector<Form> forms(12);
+    std::vector<Constraint> constraints;
+    for (const Form &form : forms)
+    {
+        constraints.insert(constraints.end(), form.constraints.begin(), form.constraints.end());
+        // Pin the left side so that each form has a single optimum.
+        constraints.push_back((form.left == 20) | strength::weak);
+    }
+    std::size_t removedCount = constraints.size() / 2;
+    std::vector<Constraint> removed(constraints.begin(), constraints.begin() + removedCount);
+
+    WorkStealingPool pool(4);
+    Solver serial;
+    Solver parallel;
+    parallel.setExecutor(&pool);
+    for (Solver *solver : {&serial, &parallel})
+    {
+        for (const Form &form : forms)
+        {
+            solver->addEditVariable(form.width, strength::strong);
+            solver->addEditVariable(form.height, strength::strong);
+        }
+        solver->addConstraints(constraints.begin(), constraints.end());
+    }
+    check_same_values(forms, serial, parallel);
+    std::uint64_t tick = id_tick(serial);
+    CHECK(id_tick(parallel) == tick);
+
+    // The serial solver reuses the ids of the removed constraints where
+    // the executor draws fresh ones, so the tableaux differ from then on
+    // but the single optimum is the same.
+    for (Solver *solver : {&serial, &parallel})
+    {
+        solver->removeConstraints(removed.begin(), removed.end());
+        solver->addConstraints(removed.begin(), removed.end());
+    }
+    CHECK(id_tick(serial) == tick);
+    CHECK(id_tick(parallel) > tick);
+    std::vector<Variable> vars;
+    for (const Form &form : forms)
+        vars.insert(vars.end(), {form.left, form.top, form.right, form.bottom, form.width, form.height, form.label});
+    std::vector<double> serialValues(vars.size());
+    std::vector<double> parallelValues(vars.size());
+    for (int step = 0; step < 5; ++step)
+    {
+        for (std::size_t i = 0; i < forms.size(); ++i)
+        {
+            serial.suggestValue(forms[i].width, 100.0 + 90.0 * double((i + step) % 6));
+            parallel.suggestValue(forms[i].width, 100.0 + 90.0 * double((i + step) % 6));
+        }
+        serial.exportValues(vars.begin(), vars.end(), serialValues.data());
+        parallel.exportValues(vars.begin(), vars.end(), parallelValues.data());
+        for (std::size_t i = 0; i < vars.size(); ++i)
+            CHECK_CLOSE(serialValues[i], parallelValues[i]);
+    }
+}
+
+int main()
+{
+    test_batches_reuse_ids();
+    test_batches_on_executor_keep_ids_bounded();
+    test_executor_matches_serial_solver();
+    test_executor_after_removals();
+    return check::result();
+}
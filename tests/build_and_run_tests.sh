@@ -0,0 +1,16 @@
+#!/bin/bash
+
+set -o errexit -o nounset  # fail on error or on unset variables
+
+# set default values if variables are unset
+: "${CXX_COMPILER:=g++}"
+: "${CXX_FLAGS:=-std=c++11}"
+
+for test in *_test.cpp; do
+    "$CXX_COMPILER" ${CXX_FLAGS} -O1 -g -Wall -Wextra -pedantic -pthread -I.. "$test" -o "run_${test%.cpp}"
+done
+
+for test in *_test.cpp; do
+    echo "${test%.cpp}"
+    "./run_${test%.cpp}"
+done
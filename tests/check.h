@@ -0,0 +1,61 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+#pragma once
+
+// The checks of the C++ tests. A failed check is reported with its
+// location and the test exits with a failure status.
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace check
+{
+
+inline int &failures()
+{
+    static int count = 0;
+    return count;
+}
+
+inline void report(bool ok, const char *expression, const char *file, int line)
+{
+    if (ok)
+        return;
+    ++failures();
+    std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+}
+
+inline int result()
+{
+    if (failures() == 0)
+        return EXIT_SUCCESS;
+    std::cerr << failures() << " checks failed" << std::endl;
+    return EXIT_FAILURE;
+}
+
+} // namespace check
+
+#define CHECK(expression) check::report(bool(expression), #expression, __FILE__, __LINE__)
+
+#define CHECK_CLOSE(first, second) CHECK(std::fabs(double(first) - double(second)) < 1e-8)
+
+#define CHECK_THROWS(statement, exception)   \
+    do                                       \
+    {                                        \
+        bool thrown = false;                 \
+        try                                  \
+        {                                    \
+            statement;                       \
+        }                                    \
+        catch (const exception &)            \
+        {                                    \
+            thrown = true;                   \
+        }                                    \
+        CHECK(thrown && #exception);         \
+    } while (false)
@@ -0,0 +1,123 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Check that a solver and its clones are independent.
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "check.h"
+
+// The solver can be forward declared.
+namespace kiwi
+{
+class Solver;
+}
+
+std::unique_ptr<kiwi::Solver> clone_of(const kiwi::Solver &solver);
+
+#include <kiwi/kiwi.h>
+
+using namespace kiwi;
+
+std::unique_ptr<Solver> clone_of(const Solver &solver)
+{
+    return solver.clone();
+}
+
+struct System
+{
+    System() : x("x"), y("y"), w("w")
+    {
+        variables = {x, y, w};
+        constraints = {y == x + 10, (y <= 50) | strength::strong, w >= 0, (w == 5) | strength::weak};
+        solver.addConstraints(constraints.begin(), constraints.end());
+        solver.addEditVariable(x, strength::medium);
+        solver.suggestValue(x, 45);
+    }
+
+    // The values of the variables read from a solver, which does not
+    // write them to the variables shared by the clones.
+    std::vector<double> values(Solver &target)
+    {
+        std::vector<double> result(variables.size());
+        target.exportValues(variables.begin(), variables.end(), result.data());
+        return result;
+    }
+
+    Variable x, y, w;
+    std::vector<Variable> variables;
+    std::vector<Constraint> constraints;
+    Solver solver;
+};
+
+// Change a solver in every way a clone could share with its source.
+void modify(Solver &solver, System &system, const Constraint &added)
+{
+    solver.suggestValue(system.x, 10);
+    solver.addConstraint(added);
+    solver.removeConstraint(system.constraints[3]);
+    solver.addEditVariable(system.w, strength::strong);
+    solver.suggestValue(system.w, 8);
+}
+
+void check_unchanged(Solver &solver, System &system, const Constraint &added, const std::string &dump)
+{
+    std::vector<double> expected = {40, 50, 5};
+    CHECK(system.values(solver) == expected);
+    CHECK(!solver.hasConstraint(added));
+    CHECK(solver.hasConstraint(system.constraints[3]));
+    CHECK(!solver.hasEditVariable(system.w));
+    CHECK(solver.dumps() == dump);
+}
+
+void test_modifying_clone()
+{
+    System system;
+    std::string dump = system.solver.dumps();
+    Constraint added = system.x >= 20;
+
+    std::unique_ptr<Solver> clone = clone_of(system.solver);
+    CHECK(system.values(*clone) == system.values(system.solver));
+    modify(*clone, system, added);
+    std::vector<double> expected = {20, 30, 8};
+    CHECK(system.values(*clone) == expected);
+    check_unchanged(system.solver, system, added, dump);
+
+    // The source can still be modified on its own.
+    system.solver.suggestValue(system.x, 0);
+    CHECK(system.values(system.solver)[1] == 10);
+    CHECK(system.values(*clone) == expected);
+}
+
+void test_modifying_source()
+{
+    System system;
+    std::unique_ptr<Solver> clone = system.solver.clone();
+    std::string dump = clone->dumps();
+    Constraint added = system.x >= 20;
+
+    modify(system.solver, system, added);
+    std::vector<double> expected = {20, 30, 8};
+    CHECK(system.values(system.solver) == expected);
+    check_unchanged(*clone, system, added, dump);
+
+    // Dropping the source leaves the clone working.
+    system.solver.reset();
+    check_unchanged(*clone, system, added, dump);
+    clone->suggestValue(system.x, 0);
+    clone->updateVariables();
+    CHECK_CLOSE(system.y.value(), 10);
+}
+
+int main()
+{
+    test_modifying_clone();
+    test_modifying_source();
+    return check::result();
+}
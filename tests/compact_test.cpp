@@ -0,0 +1,124 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Check renumbering the symbols of the solver into a dense range.
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <kiwi/kiwi.h>
+#include "check.h"
+
+using namespace kiwi;
+
+std::uint64_t id_tick(Solver &solver)
+{
+    std::vector<char> buffer;
+    solver.save(buffer, [](const Variable &) { return 0; }, [](const Constraint &) { return 0; });
+    impl::SnapshotHeader header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    return header.idTick;
+}
+
+struct System
+{
+    System()
+    {
+        for (int i = 0; i < 10; ++i)
+            vars.push_back(Variable("v"));
+        for (std::size_t i = 1; i < vars.size(); ++i)
+        {
+            kept.push_back(vars[i] >= vars[i - 1] + 5);
+            dropped.push_back((vars[i] == 3 * double(i)) | strength::weak);
+        }
+        kept.push_back((vars[0] == 1) | strength::medium);
+        solver.addConstraints(kept.begin(), kept.end());
+        solver.addConstraints(dropped.begin(), dropped.end());
+        solver.addEditVariable(vars[9], strength::strong);
+        solver.suggestValue(vars[9], 100);
+    }
+
+    std::vector<double> values()
+    {
+        std::vector<double> result(vars.size());
+        solver.exportValues(vars.begin(), vars.end(), result.data());
+        return result;
+    }
+
+    std::vector<Variable> vars;
+    std::vector<Constraint> kept;
+    std::vector<Constraint> dropped;
+    Solver solver;
+};
+
+void test_compacting_ids()
+{
+    System system;
+    std::uint64_t full = id_tick(system.solver);
+
+    // The ids of the rejected constraint are lost until compacting.
+    Variable other("other");
+    Constraint fixed = other == 1;
+    system.solver.addConstraint(fixed);
+    CHECK_THROWS(system.solver.addConstraint(other == 2), UnsatisfiableConstraint);
+    system.solver.removeConstraint(fixed);
+    system.solver.removeConstraints(system.dropped.begin(), system.dropped.end());
+    std::vector<double> values = system.values();
+    CHECK(id_tick(system.solver) > full / 2);
+
+    system.solver.compact();
+    std::uint64_t tick = id_tick(system.solver);
+    CHECK(tick < full);
+    CHECK(system.values() == values);
+
+    // The renumbered solver keeps working and reuses no stale id.
+    system.solver.suggestValue(system.vars[9], 200);
+    std::vector<double> moved = system.values();
+    CHECK_CLOSE(moved[9], 200);
+    CHECK_CLOSE(moved[0], 1);
+    system.solver.addConstraints(system.dropped.begin(), system.dropped.end());
+    CHECK(system.solver.hasConstraint(system.dropped[0]));
+    system.solver.removeConstraint(system.kept.back());
+    system.solver.removeEditVariable(system.vars[9]);
+    system.solver.updateVariables();
+    for (std::size_t i = 1; i < system.vars.size(); ++i)
+        CHECK(system.vars[i].value() >= system.vars[i - 1].value() + 5 - 1e-8);
+
+    // Compacting a dense solver changes nothing.
+    system.solver.compact();
+    tick = id_tick(system.solver);
+    std::string dump = system.solver.dumps();
+    system.solver.compact();
+    CHECK(id_tick(system.solver) == tick);
+    CHECK(system.solver.dumps() == dump);
+}
+
+void test_compacting_pulled_variables()
+{
+    System system;
+    system.solver.setPullValues(true);
+    system.solver.removeConstraints(system.dropped.begin(), system.dropped.end());
+    system.solver.updateVariables();
+    std::vector<double> values = system.values();
+    system.solver.compact();
+    for (std::size_t i = 0; i < values.size(); ++i)
+        CHECK_CLOSE(system.vars[i].value(), values[i]);
+
+    // The variables resolve their new ids after the next update.
+    system.solver.suggestValue(system.vars[9], 200);
+    system.solver.updateVariables();
+    CHECK_CLOSE(system.vars[9].value(), 200);
+    CHECK_CLOSE(system.vars[0].value(), 1);
+}
+
+int main()
+{
+    test_compacting_ids();
+    test_compacting_pulled_variables();
+    return check::result();
+}
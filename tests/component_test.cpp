@@ -0,0 +1,90 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Check tracking the independent parts of the system.
+
+#include <vector>
+#include <kiwi/kiwi.h>
+#include "check.h"
+
+using namespace kiwi;
+
+void test_component_index()
+{
+    impl::ComponentIndex index;
+    CHECK(index.find(7) == 7);
+    index.unite(1, 2);
+    index.unite(3, 4);
+    CHECK(index.find(1) == index.find(2));
+    CHECK(index.find(1) != index.find(3));
+    index.unite(2, 4);
+    CHECK(index.find(1) == index.find(3));
+    CHECK(index.find(5) == 5);
+
+    // A long chain is flattened as it is searched.
+    for (impl::ComponentIndex::Id id = 10; id < 1000; ++id)
+        index.unite(id, id + 1);
+    CHECK(index.find(10) == index.find(1000));
+    CHECK(index.find(10) != index.find(1));
+
+    CHECK(!index.stale());
+    index.setStale();
+    CHECK(index.stale());
+    index.clear();
+    CHECK(!index.stale());
+    CHECK(index.find(2) == 2);
+}
+
+void test_counting_parts()
+{
+    Variable a("a"), b("b"), c("c"), d("d"), e("e");
+    Solver solver;
+    CHECK(solver.componentCount() == 0);
+    CHECK(!solver.connected(a, b));
+
+    Constraint ab = a == b + 1;
+    Constraint cd = (c <= d) | strength::strong;
+    solver.addConstraint(ab);
+    solver.addConstraint(cd);
+    solver.addEditVariable(e, strength::weak);
+    CHECK(solver.componentCount() == 3);
+    CHECK(solver.connected(a, b));
+    CHECK(solver.connected(c, d));
+    CHECK(!solver.connected(a, c));
+    CHECK(solver.connected(e, e));
+    CHECK(!solver.connected(a, Variable("unknown")));
+
+    // Adding a constraint joins parts and removing it splits them again.
+    Constraint bc = b + c >= 10;
+    solver.addConstraint(bc);
+    CHECK(solver.componentCount() == 2);
+    CHECK(solver.connected(a, d));
+    solver.removeConstraint(bc);
+    CHECK(solver.componentCount() == 3);
+    CHECK(!solver.connected(a, d));
+
+    // A variable whose constraints are all removed is a part of its own.
+    solver.removeConstraint(ab);
+    CHECK(!solver.connected(a, b));
+
+    // Pivots keep the parts, and so do transactions rolled back.
+    solver.suggestValue(e, 4);
+    solver.beginTransaction();
+    solver.addConstraint(e == d);
+    CHECK(solver.connected(e, c));
+    solver.rollback();
+    CHECK(!solver.connected(e, c));
+    CHECK(solver.connected(c, d));
+}
+
+int main()
+{
+    test_component_index();
+    test_counting_parts();
+    return check::result();
+}
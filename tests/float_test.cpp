@@ -0,0 +1,140 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Check a solver computing with float coefficients against a double one.
+
+#include <cmath>
+#include <vector>
+#include <kiwi/kiwi.h>
+#include "check.h"
+
+using namespace kiwi;
+
+// A row of boxes fitted in a window, whose layout only needs a pixel
+// precision.
+struct Layout
+{
+    Layout() : window("window")
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            left.push_back(Variable("left"));
+            width.push_back(Variable("width"));
+        }
+        constraints.push_back(left[0] == 10);
+        for (std::size_t i = 0; i < left.size(); ++i)
+        {
+            constraints.push_back(width[i] >= 20);
+            constraints.push_back((width[i] == 100 + 10 * double(i)) | strength::weak);
+            if (i > 0)
+                constraints.push_back(left[i] == left[i - 1] + width[i - 1] + 5);
+        }
+        constraints.push_back(left.back() + width.back() <= window - 10);
+        constraints.push_back((width[0] == width[1]) | strength::medium);
+    }
+
+    template <typename S>
+    void setUp(S &solver)
+    {
+        solver.addConstraints(constraints.begin(), constraints.end());
+        solver.addEditVariable(window, strength::strong);
+    }
+
+    template <typename S>
+    std::vector<double> values(S &solver)
+    {
+        std::vector<Variable> vars = left;
+        vars.insert(vars.end(), width.begin(), width.end());
+        std::vector<double> result(vars.size());
+        solver.exportValues(vars.begin(), vars.end(), result.data());
+        return result;
+    }
+
+    Variable window;
+    std::vector<Variable> left;
+    std::vector<Variable> width;
+    std::vector<Constraint> constraints;
+};
+
+// The float solver must agree with the double one within a pixel.
+bool close(const std::vector<double> &first, const std::vector<double> &second)
+{
+    for (std::size_t i = 0; i < first.size(); ++i)
+    {
+        if (std::fabs(first[i] - second[i]) > 1e-2)
+            return false;
+    }
+    return first.size() == second.size();
+}
+
+void test_float_solver_matches_double_solver()
+{
+    Layout layout;
+    BasicSolver<float> single;
+    Solver reference;
+    layout.setUp(single);
+    layout.setUp(reference);
+
+    for (double window : {2000.0, 1200.0, 700.0, 400.0, 150.0, 1000.0})
+    {
+        single.suggestValue(layout.window, window);
+        reference.suggestValue(layout.window, window);
+        CHECK(close(layout.values(single), layout.values(reference)));
+    }
+
+    // The weak and medium strengths are still ordered below the strong one.
+    single.suggestValue(layout.window, 400);
+    std::vector<double> values = layout.values(single);
+    CHECK(std::fabs(values[7] + values[15] - 390) < 1e-2);
+    CHECK(std::fabs(values[8] - values[9]) < 1e-2);
+
+    // The weak widths then shrink in any way which fits the window.
+    single.removeConstraint(layout.constraints.back());
+    values = layout.values(single);
+    CHECK(std::fabs(values[7] + values[15] - 390) < 1e-2);
+    for (std::size_t i = 8; i < values.size(); ++i)
+        CHECK(values[i] > 20 - 1e-2);
+}
+
+void test_float_solver_updates_variables()
+{
+    Layout layout;
+    BasicSolver<float> single;
+    layout.setUp(single);
+    single.suggestValue(layout.window, 2000);
+    single.updateVariables();
+    CHECK(std::fabs(layout.left[0].value() - 10) < 1e-2);
+    CHECK(std::fabs(layout.width[7].value() - 170) < 1e-2);
+    CHECK_THROWS(single.addConstraint(layout.width[0] <= 10), UnsatisfiableConstraint);
+}
+
+void test_float_solver_keeps_light_weak_strengths()
+{
+    // Without a strong strength in the objective, the weak strengths are
+    // told apart however light they are.
+    Variable x("x");
+    BasicSolver<float> single;
+    single.addConstraint((x == 0) | strength::create(0, 0, 0.1));
+    single.addConstraint((x == 100) | strength::create(0, 0, 0.2));
+    single.updateVariables();
+    CHECK(std::fabs(x.value() - 100) < 1e-2);
+
+    Variable y("y");
+    single.addConstraint((y == 0) | strength::create(0, 0, 0.5));
+    single.addConstraint((y == 50) | strength::create(0, 0, 0.25));
+    single.updateVariables();
+    CHECK(std::fabs(y.value()) < 1e-2);
+}
+
+int main()
+{
+    test_float_solver_matches_double_solver();
+    test_float_solver_updates_variables();
+    test_float_solver_keeps_light_weak_strengths();
+    return check::result();
+}
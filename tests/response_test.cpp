@@ -0,0 +1,111 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Check that the cached response of an edit variable follows the basis.
+
+#include <cmath>
+#include <vector>
+#include <kiwi/kiwi.h>
+#include "check.h"
+
+using namespace kiwi;
+
+// A system with a single solution for each value of x, whose basis
+// changes as x crosses 10, 15 and 40.
+struct System
+{
+    System(bool capped) : x("x"), y("y"), w("w"), v("v"), z("z"), cap(x <= 35)
+    {
+        solver.addConstraint(y == x + 10);
+        solver.addConstraint(y <= 50);
+        solver.addConstraint(w >= x);
+        solver.addConstraint((w == 20) | strength::weak);
+        solver.addConstraint((v == 30 - 2 * x) | strength::medium);
+        solver.addConstraint(v >= 0);
+        solver.addConstraint((z == 7) | strength::weak);
+        solver.addEditVariable(x, strength::strong);
+        if (capped)
+            solver.addConstraint(cap);
+    }
+
+    std::vector<double> values()
+    {
+        std::vector<Variable> vars = {x, y, w, v, z};
+        std::vector<double> result(vars.size());
+        solver.exportValues(vars.begin(), vars.end(), result.data());
+        return result;
+    }
+
+    Variable x, y, w, v, z;
+    Constraint cap;
+    Solver solver;
+};
+
+bool close(const std::vector<double> &first, const std::vector<double> &second)
+{
+    for (std::size_t i = 0; i < first.size(); ++i)
+    {
+        if (std::fabs(first[i] - second[i]) > 1e-8)
+            return false;
+    }
+    return first.size() == second.size();
+}
+
+// Suggest a value to a solver which suggested others before and compare
+// it with a new solver which only suggests this one.
+void check_suggestion(System &system, bool capped, double value)
+{
+    system.solver.suggestValue(system.x, value);
+    System reference(capped);
+    reference.solver.suggestValue(reference.x, value);
+    CHECK(close(system.values(), reference.values()));
+}
+
+void test_response_across_basis_changes()
+{
+    System system(false);
+    for (double value : {0.0, 5.0, 12.0, 14.0, 18.0, 30.0, 45.0, 60.0, 39.0, 11.0, -5.0, 16.0})
+        check_suggestion(system, false, value);
+
+    // Adding and removing constraints change the basis too.
+    system.solver.addConstraint(system.cap);
+    for (double value : {16.0, 50.0, 20.0, 36.0})
+        check_suggestion(system, true, value);
+    system.solver.removeConstraint(system.cap);
+    for (double value : {36.0, 50.0, 3.0})
+        check_suggestion(system, false, value);
+
+    // So does a suggestion for another edit variable.
+    system.solver.addEditVariable(system.z, strength::strong);
+    system.solver.suggestValue(system.z, 3);
+    system.solver.suggestValue(system.x, 25);
+    system.solver.updateVariables();
+    CHECK_CLOSE(system.z.value(), 3);
+    CHECK_CLOSE(system.w.value(), 25);
+    CHECK_CLOSE(system.v.value(), 0);
+}
+
+void test_response_in_batch()
+{
+    System system(false);
+    for (double value : {5.0, 45.0, 12.0, 20.0})
+    {
+        std::vector<std::pair<Variable, double>> suggestions = {{system.x, value - 3}, {system.x, value}};
+        system.solver.suggestValues(suggestions.begin(), suggestions.end());
+        System reference(false);
+        reference.solver.suggestValue(reference.x, value);
+        CHECK(close(system.values(), reference.values()));
+    }
+}
+
+int main()
+{
+    test_response_across_basis_changes();
+    test_response_in_batch();
+    return check::result();
+}
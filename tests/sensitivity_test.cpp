@@ -0,0 +1,112 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Check the derivatives of the variables against finite differences.
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <kiwi/kiwi.h>
+#include "check.h"
+
+using namespace kiwi;
+
+// A system with a single solution for each value of x, whose slopes
+// change as x crosses 10, 15 and 40.
+struct System
+{
+    System() : x("x"), y("y"), w("w"), v("v"), z("z")
+    {
+        vars = {x, y, w, v, z};
+        solver.addConstraint(y == x + 10);
+        solver.addConstraint(y <= 50);
+        solver.addConstraint(w >= x);
+        solver.addConstraint((w == 20) | strength::weak);
+        solver.addConstraint((v == 30 - 2 * x) | strength::medium);
+        solver.addConstraint(v >= 0);
+        solver.addConstraint((z == 7) | strength::weak);
+        solver.addEditVariable(x, strength::strong);
+    }
+
+    std::vector<double> values()
+    {
+        std::vector<double> result(vars.size());
+        solver.exportValues(vars.begin(), vars.end(), result.data());
+        return result;
+    }
+
+    // The derivatives in the order of the variables, zero for those which
+    // are not listed.
+    std::vector<double> derivatives()
+    {
+        std::vector<std::pair<Variable, double>> pairs;
+        solver.sensitivity(x, pairs);
+        std::vector<double> result(vars.size(), 0.0);
+        for (const auto &pair : pairs)
+        {
+            for (std::size_t i = 0; i < vars.size(); ++i)
+            {
+                if (pair.first.name() == vars[i].name())
+                    result[i] = pair.second;
+            }
+        }
+        return result;
+    }
+
+    Variable x, y, w, v, z;
+    std::vector<Variable> vars;
+    Solver solver;
+};
+
+void test_derivatives_match_finite_differences()
+{
+    System system;
+    const double step = 0.5;
+    for (double value : {0.0, 12.0, 25.0, 45.0, 13.0, -8.0})
+    {
+        system.solver.suggestValue(system.x, value);
+        std::vector<double> derivatives = system.derivatives();
+        std::vector<double> before = system.values();
+        system.solver.suggestValue(system.x, value + step);
+        std::vector<double> after = system.values();
+        for (std::size_t i = 0; i < derivatives.size(); ++i)
+            CHECK_CLOSE(derivatives[i], (after[i] - before[i]) / step);
+    }
+
+    // Past the bound of y, nothing moves with x any more.
+    system.solver.suggestValue(system.x, 60);
+    for (double derivative : system.derivatives())
+        CHECK(derivative == 0.0);
+}
+
+void test_derivatives_after_changes()
+{
+    System system;
+    system.solver.suggestValue(system.x, 25);
+    std::vector<double> expected = {1, 1, 1, 0, 0};
+    CHECK(system.derivatives() == expected);
+
+    // Adding a constraint changes the basis and the derivatives.
+    Constraint tie = (system.z == 2 * system.x) | strength::medium;
+    system.solver.addConstraint(tie);
+    expected = {1, 1, 1, 0, 2};
+    CHECK(system.derivatives() == expected);
+    system.solver.removeConstraint(tie);
+    expected = {1, 1, 1, 0, 0};
+    CHECK(system.derivatives() == expected);
+
+    std::vector<std::pair<Variable, double>> pairs;
+    CHECK_THROWS(system.solver.sensitivity(system.y, pairs), UnknownEditVariable);
+}
+
+int main()
+{
+    test_derivatives_match_finite_differences();
+    test_derivatives_after_changes();
+    return check::result();
+}
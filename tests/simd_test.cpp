@@ -0,0 +1,70 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Check that every kernel path finds the values nearZero finds.
+
+#include <cmath>
+#include <vector>
+#include <kiwi/kiwi.h>
+#include "check.h"
+
+using namespace kiwi;
+using namespace kiwi::impl;
+
+template <typename T>
+using FindNearZero = std::size_t (*)(const T *, std::size_t);
+
+template <typename T>
+std::vector<FindNearZero<T>> kernels()
+{
+    std::vector<FindNearZero<T>> result = {simd::findNearZeroScalar<T>, simd::Kernels<T>::get().findNearZero};
+#ifdef KIWI_SIMD_X86
+    result.push_back(simd::findNearZeroSSE2);
+    if (simd::cpuHasAVX2())
+        result.push_back(simd::findNearZeroAVX2);
+#endif
+    return result;
+}
+
+// Place each value around the epsilon of the scalar type at every
+// position of arrays of every length up to two AVX2 vectors.
+template <typename T>
+void check_kernels(const std::vector<FindNearZero<T>> &found)
+{
+    const T eps = ScalarTraits<T>::epsilon();
+    const T zero = T(0);
+    const T values[] = {zero, -zero, eps, -eps, std::nextafter(eps, zero), -std::nextafter(eps, zero),
+                        std::nextafter(eps, T(1)), eps / T(2), T(1)};
+    for (T value : values)
+    {
+        for (std::size_t count = 1; count <= 16; ++count)
+        {
+            for (std::size_t at = 0; at < count; ++at)
+            {
+                std::vector<T> data(count, T(1));
+                data[at] = value;
+                std::size_t expected = nearZero(value) ? at : count;
+                for (FindNearZero<T> findNearZero : found)
+                    CHECK(findNearZero(data.data(), count) == expected);
+            }
+        }
+    }
+}
+
+void test_kernels_use_the_epsilon_of_the_scalar()
+{
+    check_kernels<double>(kernels<double>());
+    check_kernels<float>(kernels<float>());
+    check_kernels<long double>({simd::findNearZeroScalar<long double>, simd::Kernels<long double>::get().findNearZero});
+}
+
+int main()
+{
+    test_kernels_use_the_epsilon_of_the_scalar();
+    return check::result();
+}
@@ -0,0 +1,225 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Check saving and loading snapshots of the solver state.
+
+#include <cstring>
+#include <limits>
+#include <map>
+#include <vector>
+#include <kiwi/kiwi.h>
+#include "check.h"
+
+using namespace kiwi;
+using impl::Symbol;
+
+struct Layout
+{
+    std::size_t freeIds;
+    std::size_t variables;
+    std::vector<std::size_t> rows;  // the objective first
+};
+
+struct System
+{
+    System() : x("x"), y("y"), w("w")
+    {
+        variables = {x, y, w};
+        constraints = {y == x + 10, (y <= 50) | strength::strong, w >= 0, (w == 5) | strength::weak};
+        solver.addConstraints(constraints.begin(), constraints.end());
+        solver.addEditVariable(x, strength::medium);
+        solver.suggestValue(x, 45);
+        // Leave a free id in the snapshot.
+        solver.removeConstraint(constraints.back());
+        constraints.pop_back();
+    }
+
+    void save(std::vector<char> &buffer)
+    {
+        solver.save(
+            buffer,
+            [this](const Variable &variable) { return index(variables, variable); },
+            [this](const Constraint &constraint) { return index(constraints, constraint); });
+    }
+
+    void load(Solver &target, const std::vector<char> &buffer)
+    {
+        target.load(
+            buffer.data(), buffer.size(),
+            [this](std::uint64_t key) { return at(variables, key); },
+            [this](std::uint64_t key) { return at(constraints, key); });
+    }
+
+    template <typename U>
+    static std::uint64_t index(const std::vector<U> &items, const U &item)
+    {
+        std::map<U, std::uint64_t> keys;
+        for (std::size_t i = 0; i < items.size(); ++i)
+            keys[items[i]] = i;
+        return keys.at(item);
+    }
+
+    template <typename U>
+    static U at(const std::vector<U> &items, std::uint64_t key)
+    {
+        if (key >= items.size())
+            throw BadSnapshot("The snapshot has an unknown key.");
+        return items[std::size_t(key)];
+    }
+
+    Variable x, y, w;
+    std::vector<Variable> variables;
+    std::vector<Constraint> constraints;
+    Solver solver;
+};
+
+Layout layout(const std::vector<char> &buffer)
+{
+    impl::SnapshotHeader header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    Layout result;
+    std::size_t offset = sizeof(header);
+    result.freeIds = offset;
+    offset += 8 * std::size_t(header.freeIds);
+    result.variables = offset;
+    offset += 16 * std::size_t(header.variables);
+    offset += 24 * std::size_t(header.constraints) + 40 * std::size_t(header.edits);
+    for (std::uint64_t i = 0; i <= header.rows; ++i)
+    {
+        result.rows.push_back(offset);
+        std::uint64_t size;
+        std::memcpy(&size, &buffer[offset + 8], sizeof(size));
+        offset += 24 + 16 * std::size_t(size);
+    }
+    return result;
+}
+
+template <typename U>
+U peek(const std::vector<char> &buffer, std::size_t offset)
+{
+    U value;
+    std::memcpy(static_cast<void *>(&value), &buffer[offset], sizeof(U));
+    return value;
+}
+
+template <typename U>
+void poke(std::vector<char> &buffer, std::size_t offset, const U &value)
+{
+    std::memcpy(&buffer[offset], static_cast<const void *>(&value), sizeof(U));
+}
+
+// Load a corrupt snapshot, which must be rejected and leave the solver empty.
+void check_rejected(System &system, const std::vector<char> &buffer)
+{
+    Solver target;
+    CHECK_THROWS(system.load(target, buffer), BadSnapshot);
+    CHECK(!target.hasConstraint(system.constraints[0]));
+    CHECK(!target.hasEditVariable(system.x));
+}
+
+void test_loading_snapshot()
+{
+    System system;
+    std::vector<char> buffer;
+    system.save(buffer);
+
+    Solver target;
+    system.load(target, buffer);
+    CHECK(target.hasConstraint(system.constraints[0]));
+    CHECK(target.hasEditVariable(system.x));
+    target.updateVariables();
+    CHECK_CLOSE(system.x.value(), 40);
+    CHECK_CLOSE(system.y.value(), 50);
+
+    target.suggestValue(system.x, 20);
+    target.updateVariables();
+    CHECK_CLOSE(system.y.value(), 30);
+}
+
+void test_rejecting_corrupt_snapshots()
+{
+    System system;
+    std::vector<char> valid;
+    system.save(valid);
+    Layout offsets = layout(valid);
+    CHECK(offsets.freeIds != offsets.variables);
+
+    std::vector<char> buffer = valid;
+    Symbol var = peek<Symbol>(valid, offsets.variables + 8);
+    poke(buffer, offsets.variables + 8, Symbol(var.type(), var.id() + (Symbol::Id(1) << 30)));
+    check_rejected(system, buffer);
+
+    buffer = valid;
+    poke(buffer, offsets.variables + 8, Symbol(Symbol::Slack, var.id()));
+    check_rejected(system, buffer);
+
+    buffer = valid;
+    poke(buffer, offsets.variables + 8, Symbol(Symbol::External, 0));
+    check_rejected(system, buffer);
+
+    buffer = valid;
+    poke(buffer, offsets.variables + 24, peek<Symbol>(valid, offsets.variables + 8));
+    check_rejected(system, buffer);
+
+    buffer = valid;
+    poke(buffer, offsets.freeIds, std::uint64_t(var.id()));
+    check_rejected(system, buffer);
+
+    buffer = valid;
+    poke(buffer, offsets.rows[2], peek<Symbol>(valid, offsets.rows[1]));
+    check_rejected(system, buffer);
+
+    buffer = valid;
+    poke(buffer, offsets.rows[0], peek<Symbol>(valid, offsets.rows[1]));
+    check_rejected(system, buffer);
+
+    // Swap the first two cells of a row.
+    for (std::size_t row : offsets.rows)
+    {
+        if (peek<std::uint64_t>(valid, row + 8) < 2)
+            continue;
+        buffer = valid;
+        poke(buffer, row + 24, peek<Symbol>(valid, row + 32));
+        poke(buffer, row + 32, peek<Symbol>(valid, row + 24));
+        check_rejected(system, buffer);
+        break;
+    }
+
+    buffer = valid;
+    poke(buffer, offsets.rows[1] + 16, std::numeric_limits<double>::quiet_NaN());
+    check_rejected(system, buffer);
+}
+
+void test_flipping_bits()
+{
+    System system;
+    std::vector<char> valid;
+    system.save(valid);
+    for (std::size_t bit = 0; bit < valid.size() * 8; ++bit)
+    {
+        std::vector<char> buffer = valid;
+        buffer[bit / 8] ^= char(1 << (bit % 8));
+        Solver target;
+        try
+        {
+            system.load(target, buffer);
+        }
+        catch (const BadSnapshot &)
+        {
+            CHECK(!target.hasConstraint(system.constraints[0]));
+        }
+    }
+}
+
+int main()
+{
+    test_loading_snapshot();
+    test_rejecting_corrupt_snapshots();
+    test_flipping_bits();
+    return check::result();
+}
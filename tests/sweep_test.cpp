@@ -0,0 +1,103 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Check sweeping an edit variable against solving each value on its own.
+
+#include <string>
+#include <vector>
+#include <kiwi/kiwi.h>
+#include "check.h"
+
+using namespace kiwi;
+
+// A system whose solution bends several times as x grows, two of its
+// bends being at the same value.
+struct System
+{
+    System() : x("x"), y("y"), w("w"), u("u"), v("v")
+    {
+        solver.addConstraint(y == x + 10);
+        solver.addConstraint(y <= 50);
+        solver.addConstraint((w == y - 10) | strength::strong);
+        solver.addConstraint(w <= 40);
+        solver.addConstraint(u >= x);
+        solver.addConstraint((u == 20) | strength::weak);
+        solver.addConstraint((v == 30 - 2 * x) | strength::medium);
+        solver.addConstraint(v >= 0);
+        solver.addEditVariable(x, strength::strong);
+    }
+
+    Variable x, y, w, u, v;
+    Solver solver;
+};
+
+void test_sweep_matches_each_value()
+{
+    System system;
+    system.solver.suggestValue(system.x, 5);
+    Sweep sweep = system.solver.sweep(system.x, -20, 60);
+    CHECK(sweep.breakpoints().front() == -20);
+    CHECK(sweep.breakpoints().back() == 60);
+    CHECK(sweep.segmentCount() >= 3);
+
+    // The solver is left solved for the value suggested before the sweep.
+    system.solver.updateVariables();
+    CHECK_CLOSE(system.x.value(), 5);
+    CHECK_CLOSE(system.u.value(), 20);
+
+    const std::vector<Variable> &variables = sweep.variables();
+    CHECK(variables.size() == 5);
+    std::vector<double> values(variables.size());
+    System reference;
+    for (double value = -20; value <= 60; value += 0.25)
+    {
+        reference.solver.suggestValue(reference.x, value);
+        reference.solver.updateVariables();
+        sweep.evaluate(value, values.data());
+        // The variables of both systems have the same names.
+        for (const Variable &expected : {reference.x, reference.y, reference.w, reference.u, reference.v})
+        {
+            for (std::size_t i = 0; i < variables.size(); ++i)
+            {
+                if (variables[i].name() == expected.name())
+                    CHECK_CLOSE(values[i], expected.value());
+            }
+        }
+    }
+
+    sweep.apply(25);
+    CHECK_CLOSE(system.x.value(), 25);
+    CHECK_CLOSE(system.u.value(), 25);
+    CHECK_CLOSE(system.v.value(), 0);
+}
+
+void test_sweep_of_reversed_range()
+{
+    System system;
+    Sweep sweep = system.solver.sweep(system.x, 60, -20);
+    CHECK(sweep.breakpoints().front() == -20);
+    CHECK(sweep.breakpoints().back() == 60);
+    for (std::size_t i = 1; i < sweep.breakpoints().size(); ++i)
+        CHECK(sweep.breakpoints()[i - 1] < sweep.breakpoints()[i]);
+    CHECK(sweep.segmentFor(-100) == 0);
+    CHECK(sweep.segmentFor(100) == sweep.segmentCount() - 1);
+}
+
+void test_sweep_of_unknown_edit_variable()
+{
+    System system;
+    CHECK_THROWS(system.solver.sweep(system.y, 0, 10), UnknownEditVariable);
+}
+
+int main()
+{
+    test_sweep_matches_each_value();
+    test_sweep_of_reversed_range();
+    test_sweep_of_unknown_edit_variable();
+    return check::result();
+}
@@ -0,0 +1,209 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Check that rolling back a transaction restores the solver.
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <kiwi/kiwi.h>
+#include "check.h"
+
+using namespace kiwi;
+
+struct System
+{
+    System() : x("x"), y("y"), w("w")
+    {
+        base = {y == x + 10, (y <= 50) | strength::strong, w >= 0};
+        solver.addConstraints(base.begin(), base.end());
+        solver.addEditVariable(x, strength::medium);
+        solver.suggestValue(x, 45);
+        solver.updateVariables();
+    }
+
+    Variable x, y, w;
+    std::vector<Constraint> base;
+    Solver solver;
+};
+
+std::uint64_t id_tick(Solver &solver)
+{
+    std::vector<char> buffer;
+    solver.save(buffer, [](const Variable &) { return 0; }, [](const Constraint &) { return 0; });
+    impl::SnapshotHeader header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    return header.idTick;
+}
+
+// The lines of a dump, sorted as the maps of the solver are unordered.
+std::vector<std::string> dump_lines(Solver &solver)
+{
+    std::istringstream stream(solver.dumps());
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(stream, line);)
+        lines.push_back(line);
+    std::sort(lines.begin(), lines.end());
+    return lines;
+}
+
+void check_values(System &system, double x, double y)
+{
+    system.solver.updateVariables();
+    CHECK_CLOSE(system.x.value(), x);
+    CHECK_CLOSE(system.y.value(), y);
+}
+
+void test_rolling_back_added_constraint()
+{
+    System system;
+    std::uint64_t tick = id_tick(system.solver);
+    std::vector<std::string> dump = dump_lines(system.solver);
+    Constraint added = system.x <= 20;
+
+    system.solver.beginTransaction();
+    system.solver.addConstraint(added);
+    CHECK(system.solver.hasConstraint(added));
+    std::uint64_t addedTick = id_tick(system.solver);
+    CHECK(addedTick > tick);
+    check_values(system, 20, 30);
+    system.solver.rollback();
+
+    CHECK(system.solver.transactionDepth() == 0);
+    CHECK(!system.solver.hasConstraint(added));
+    CHECK(id_tick(system.solver) == tick);
+    CHECK(dump_lines(system.solver) == dump);
+    check_values(system, 40, 50);
+
+    // The ids released by the rollback are reused.
+    system.solver.addConstraint(added);
+    CHECK(id_tick(system.solver) == addedTick);
+    check_values(system, 20, 30);
+}
+
+void test_rolling_back_removed_constraint()
+{
+    System system;
+    std::vector<std::string> dump = dump_lines(system.solver);
+
+    system.solver.beginTransaction();
+    system.solver.removeConstraint(system.base[1]);
+    CHECK(!system.solver.hasConstraint(system.base[1]));
+    check_values(system, 45, 55);
+    system.solver.rollback();
+
+    CHECK(system.solver.hasConstraint(system.base[1]));
+    CHECK(dump_lines(system.solver) == dump);
+    check_values(system, 40, 50);
+    system.solver.removeConstraint(system.base[1]);
+    check_values(system, 45, 55);
+}
+
+void test_rolling_back_edits_and_suggestions()
+{
+    System system;
+    std::uint64_t tick = id_tick(system.solver);
+    std::vector<std::string> dump = dump_lines(system.solver);
+
+    system.solver.beginTransaction();
+    system.solver.suggestValue(system.x, 10);
+    system.solver.addEditVariable(system.w, strength::strong);
+    system.solver.suggestValue(system.w, 7);
+    system.solver.updateVariables();
+    CHECK_CLOSE(system.w.value(), 7);
+    check_values(system, 10, 20);
+    system.solver.rollback();
+
+    CHECK(!system.solver.hasEditVariable(system.w));
+    CHECK(system.solver.hasEditVariable(system.x));
+    CHECK(id_tick(system.solver) == tick);
+    CHECK(dump_lines(system.solver) == dump);
+    check_values(system, 40, 50);
+
+    system.solver.beginTransaction();
+    system.solver.removeEditVariable(system.x);
+    CHECK(!system.solver.hasEditVariable(system.x));
+    system.solver.rollback();
+    CHECK(system.solver.hasEditVariable(system.x));
+    system.solver.suggestValue(system.x, 15);
+    check_values(system, 15, 25);
+}
+
+void test_nested_transactions()
+{
+    System system;
+    Constraint outer = system.x <= 30;
+    Constraint inner = system.x <= 20;
+
+    // Rolling back the inner transaction keeps the changes of the outer one.
+    system.solver.beginTransaction();
+    system.solver.addConstraint(outer);
+    system.solver.beginTransaction();
+    CHECK(system.solver.transactionDepth() == 2);
+    system.solver.addConstraint(inner);
+    check_values(system, 20, 30);
+    system.solver.rollback();
+    CHECK(!system.solver.hasConstraint(inner));
+    CHECK(system.solver.hasConstraint(outer));
+    check_values(system, 30, 40);
+    system.solver.commit();
+    CHECK(system.solver.transactionDepth() == 0);
+    CHECK(system.solver.hasConstraint(outer));
+    check_values(system, 30, 40);
+
+    // Rolling back the outer transaction undoes the committed inner one.
+    std::vector<std::string> dump = dump_lines(system.solver);
+    system.solver.beginTransaction();
+    system.solver.beginTransaction();
+    system.solver.addConstraint(inner);
+    system.solver.removeConstraint(outer);
+    system.solver.commit();
+    CHECK(system.solver.transactionDepth() == 1);
+    check_values(system, 20, 30);
+    system.solver.rollback();
+    CHECK(!system.solver.hasConstraint(inner));
+    CHECK(system.solver.hasConstraint(outer));
+    CHECK(dump_lines(system.solver) == dump);
+    check_values(system, 30, 40);
+}
+
+void test_compacting_in_transaction()
+{
+    System system;
+    system.solver.removeConstraint(system.base[2]);
+    std::uint64_t tick = id_tick(system.solver);
+    std::vector<std::string> dump = dump_lines(system.solver);
+
+    // Compacting is a no-op while a transaction is open.
+    system.solver.beginTransaction();
+    system.solver.compact();
+    CHECK(id_tick(system.solver) == tick);
+    CHECK(dump_lines(system.solver) == dump);
+    system.solver.addConstraint(system.x <= 20);
+    system.solver.compact();
+    system.solver.rollback();
+    CHECK(id_tick(system.solver) == tick);
+    CHECK(dump_lines(system.solver) == dump);
+    check_values(system, 40, 50);
+
+    system.solver.compact();
+    CHECK(id_tick(system.solver) < tick);
+    check_values(system, 40, 50);
+}
+
+int main()
+{
+    test_rolling_back_added_constraint();
+    test_rolling_back_removed_constraint();
+    test_rolling_back_edits_and_suggestions();
+    test_nested_transactions();
+    test_compacting_in_transaction();
+    return check::result();
+}
@@ -0,0 +1,114 @@
+/*-----------------------------------------------------------------------------
+| Copyright (c) 2021, Nucleic Development Team.
+|
+| Distributed under the terms of the Modified BSD License.
+|
+| The full license is in the file LICENSE, distributed with this software.
+|----------------------------------------------------------------------------*/
+
+// Check reading the values of the solver without writing the variables.
+
+#include <vector>
+#include <kiwi/kiwi.h>
+#include "check.h"
+
+using namespace kiwi;
+
+struct System
+{
+    System() : x("x"), y("y"), w("w")
+    {
+        solver.addConstraint(y == 2 * x + 10);
+        solver.addConstraint((y <= 50) | strength::strong);
+        solver.addConstraint(w >= 0);
+        solver.addEditVariable(x, strength::medium);
+        solver.suggestValue(x, 10);
+    }
+
+    Variable x, y, w;
+    Solver solver;
+};
+
+void test_exporting_values()
+{
+    System system;
+    Variable unknown("unknown");
+    std::vector<Variable> vars = {system.x, system.y, unknown, system.w, system.x};
+    std::vector<double> values(vars.size(), -1);
+    system.solver.exportValues(vars.begin(), vars.end(), values.data());
+    std::vector<double> expected = {10, 30, 0, 0, 10};
+    CHECK(values == expected);
+
+    // The variables are not written.
+    CHECK(system.x.value() == 0);
+    CHECK(system.y.value() == 0);
+
+    system.solver.suggestValue(system.x, 30);
+    system.solver.exportValues(vars.begin(), vars.begin() + 2, values.data());
+    CHECK_CLOSE(values[0], 20);
+    CHECK_CLOSE(values[1], 50);
+}
+
+void test_value_slots()
+{
+    System system;
+    std::size_t x = system.solver.addValueSlot(system.x);
+    std::size_t y = system.solver.addValueSlot(system.y);
+    Variable free("free");
+    std::size_t added = system.solver.addValueSlot(free);
+    CHECK(system.solver.valueSlotCount() == 3);
+    CHECK(x != y && y != added);
+
+    // The slots are refreshed by the updates only.
+    system.solver.updateVariables();
+    const double *slots = system.solver.valueSlots();
+    CHECK_CLOSE(slots[x], 10);
+    CHECK_CLOSE(slots[y], 30);
+    CHECK_CLOSE(slots[added], 0);
+    system.solver.suggestValue(system.x, 15);
+    CHECK_CLOSE(system.solver.valueSlots()[y], 30);
+    system.solver.updateVariables();
+    CHECK_CLOSE(system.solver.valueSlots()[y], 40);
+
+    // A removed slot holds zero until it is reused.
+    system.solver.removeValueSlot(y);
+    CHECK(system.solver.valueSlots()[y] == 0);
+    system.solver.updateVariables();
+    CHECK(system.solver.valueSlots()[y] == 0);
+    CHECK(system.solver.addValueSlot(system.w) == y);
+    CHECK(system.solver.valueSlotCount() == 3);
+    system.solver.suggestValue(system.x, 5);
+    system.solver.updateVariables();
+    slots = system.solver.valueSlots();
+    CHECK_CLOSE(slots[x], 5);
+    CHECK_CLOSE(slots[y], 0);
+
+    // The slots stay stable as others are added.
+    std::vector<Variable> more(64);
+    for (const Variable &var : more)
+        system.solver.addValueSlot(var);
+    system.solver.updateVariables();
+    CHECK_CLOSE(system.solver.valueSlots()[x], 5);
+
+    system.solver.reset();
+    CHECK(system.solver.valueSlotCount() == 0);
+}
+
+void test_value_slots_in_pull_mode()
+{
+    System system;
+    system.solver.setPullValues(true);
+    std::size_t y = system.solver.addValueSlot(system.y);
+    system.solver.suggestValue(system.x, 20);
+    system.solver.updateVariables();
+    CHECK_CLOSE(system.solver.valueSlots()[y], 50);
+    CHECK_CLOSE(system.y.value(), 50);
+}
+
+int main()
+{
+    test_exporting_values();
+    test_value_slots();
+    test_value_slots_in_pull_mode();
+    return check::result();
+}